@@ -0,0 +1,538 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <string.h>
+#include <sched.h>
+#include <omp.h>
+#include <unistd.h>
+
+#include "open-set.h"
+#include "cell-state.h"
+#include "map.h"
+#include "path-output.h"
+
+/* Hash Distributed A* (HDA*): the search of a single path is distributed among the threads. Every cell of the map is owned by
+one thread, chosen by a hash of the block of BLOCK x BLOCK cells that contains it (a hash of the single cells would send almost
+every neighbor to another thread). Only the owner of a cell keeps its value of "g" and its parent, and expands it from its own
+open set; the neighbors generated by an expansion are sent to their owners as messages, collected in batches and appended to
+the inbox of the owner under a lock. The cells are not expanded in global order of "f", so a cell can be reached with a lower
+cost after its expansion: it is then put back in the open set of its owner and expanded again. To keep these re-expansions
+few, the threads must not run far ahead of each other: every FLUSH_EXPANSIONS expansions a thread sends its messages and
+yields the processor, which only matters when the threads are more than the cores.
+Termination is detected with a single counter, "work": the number of active threads plus the number of messages sent and not
+yet received. A thread becomes idle when it has nothing that can improve the best path found (its open set is empty or its best
+cell has f >= length of the best path) and it has sent all its messages; it becomes active again when it receives a message.
+Messages are counted before they are sent and a thread is counted as active before its messages are discounted, so "work"
+reaches 0 only when every thread is idle and no message is on its way: the search is then over. */
+
+#define ALLOC 100				// Dimension used for dynamic vector allocation
+#define BLOCK 8					// Side of the blocks of cells having the same owner
+#define MESSAGE_BATCH 256		// Maximum number of messages collected before being sent to a thread
+#define FLUSH_EXPANSIONS 64		// Number of expansions after which the messages collected are sent and the thread yields
+
+typedef struct {
+	int pos;					// Position of the cell
+	int parent;					// Direction from the cell to its parent (see "cell-state.h")
+	double g;					// Distance (cost) between the cell and the starting point through the parent
+} Message;
+
+typedef struct {
+	Message *messages;			// Messages received and not yet processed
+	int size;					// Number of messages
+	int alloc;					// Number of elements allocated for "messages"
+	omp_lock_t lock;			// Lock of the inbox
+} Inbox;
+
+typedef struct {
+	OpenSet openSet;			// Open set of the cells owned by the thread
+	Message *out;				// Messages collected for every thread (MESSAGE_BATCH per thread)
+	int *outSize;				// Number of messages collected for every thread
+	Message *received;			// Messages taken from the inbox of the thread
+	int receivedAlloc;			// Number of elements allocated for "received"
+	bool active;				// The thread is counted as active in "work"
+	long long expanded;			// Number of cells expanded
+	long long sent;				// Number of messages sent to other threads
+} Worker;
+
+typedef struct {
+	Map *map;
+	int numThreads;				// Number of threads
+	int numWorkers;				// Number of threads whose state has been allocated
+	int goal[2];				// Goal point
+	int posGoal;				// Position of the goal point
+	double *g;					// Distance (cost) between a cell and the starting point - written only by the owner of the cell
+	unsigned char *parent;		// Direction from a cell to its parent - written only by the owner of the cell
+	Inbox *inbox;				// Inbox of every thread
+	Worker *worker;				// State of every thread
+	double mu;					// Length of the best path found so far
+	long long work;				// Active threads + messages sent and not yet received
+	int failed;					// Set in case of failed allocation
+} Hda;
+
+/* Check if a cell is inside the map. If it is, it is returned true, otherwise false. */
+bool check_position (Map *map, int cell[]) {
+	if (cell[0] >= 0 && cell[0] < map->rows && cell[1] >= 0 && cell[1] < map->cols)
+		return true;
+	else
+		return false;
+}
+
+/* Check if a cell is free or not. If it is, it is returned true, otherwise false. */
+bool is_free (int cell[], Map *map) {
+	if (mapIsFree(map, cell[0], cell[1]))
+		return true;
+	else
+		return false;
+}
+
+/* Check if the goal point has been reached. If it is, it is returned true, otherwise false. */
+bool is_goal (int start[], int goal[]) {
+	if (start[0] == goal[0] && start[1] == goal[1])
+		return true;
+	else
+		return false;
+}
+
+/* Check the correctness of the starting point and the goal point, i.e., if both are within the map, if they are free
+and if their positions do not coincide. If everything is ok, it is returned true, otherwise an error message is reported
+based on the first problem encountered and it is returned false. */
+bool check (int start[], int goal[], Map *map) {
+	if (!(check_position(map, start) && check_position(map, goal))) {
+		printf("ERROR: start or goal point is out of the map!\n");
+		return false;
+	}
+
+	if (!(is_free(start, map) && is_free(goal, map))) {
+		printf("ERROR: start or goal point is not free!\n");
+		return false;
+	}
+
+	if (is_goal(start, goal)) {
+		printf("ERROR: start and goal points coincide!\n");
+		return false;
+	}
+	return true;
+}
+
+/* This function returns the Euclidean distance between two cells. */
+double distance (int a[], int b[]) {
+	double deltaRow = a[0] - b[0], deltaCol = a[1] - b[1];		// In double, since the squares may not fit in an int
+	return sqrt(deltaRow*deltaRow + deltaCol*deltaCol);
+}
+
+/* Return the thread that owns the cell (row, col): the block of the cell is hashed and mapped on the threads. */
+static inline int owner(const Hda *hda, int row, int col){
+	uint32_t hash = (uint32_t)(row / BLOCK)*0x9E3779B1u ^ (uint32_t)(col / BLOCK)*0x85EBCA77u;
+	hash ^= hash >> 15;
+	hash *= 0x2C1B3C6Du;
+	hash ^= hash >> 12;
+	return (int)(((uint64_t)hash * hda->numThreads) >> 32);
+}
+
+/* A message for a cell owned by the thread "tid" is processed: if the cell is reached with a lower cost than before, its value of
+"g" and its parent are updated and the cell is put in the open set (again, if it has already been expanded). The goal point is
+not expanded: it only updates the length of the best path. */
+void receiveCell(Hda *hda, int tid, Message *msg){
+	int pos = msg->pos;
+	if (msg->g >= hda->g[pos])
+		return;
+	hda->g[pos] = msg->g;
+	hda->parent[pos] = msg->parent;
+
+	if (pos == hda->posGoal) {
+		#pragma omp critical (hdaBestPath)
+		{
+			if (msg->g < hda->mu) {
+				#pragma omp atomic write
+				hda->mu = msg->g;
+			}
+		}
+		return;
+	}
+
+	OpenSet *openSet = &hda->worker[tid].openSet;
+	int cell[2] = {pos / hda->map->cols, pos % hda->map->cols};
+	double f = msg->g + distance(cell, hda->goal);
+	if (openSetContains(openSet, pos)) {
+		openSetDecreaseKey(openSet, pos, f);
+	} else if (!openSetPush(openSet, pos, f)) {
+		#pragma omp atomic write
+		hda->failed = 1;
+	}
+}
+
+/* Send the messages collected by the thread "tid" for the thread "dest" (if any) to its inbox. */
+void flushMessages(Hda *hda, int tid, int dest){
+	Worker *w = &hda->worker[tid];
+	int n = w->outSize[dest];
+	if (n == 0)
+		return;
+	#pragma omp atomic update
+	hda->work += n;				// Counted before the messages can be received
+
+	Inbox *inbox = &hda->inbox[dest];
+	omp_set_lock(&inbox->lock);
+	if (inbox->size + n > inbox->alloc) {
+		int alloc = (inbox->size + n > 2*inbox->alloc) ? inbox->size + n : 2*inbox->alloc;
+		Message *messages = (Message *)realloc(inbox->messages, alloc*sizeof(Message));
+		if (messages == NULL) {
+			omp_unset_lock(&inbox->lock);
+			#pragma omp atomic write
+			hda->failed = 1;
+			return;
+		}
+		inbox->messages = messages;
+		inbox->alloc = alloc;
+	}
+	memcpy(inbox->messages + inbox->size, w->out + (size_t)dest*MESSAGE_BATCH, n*sizeof(Message));
+	inbox->size += n;
+	omp_unset_lock(&inbox->lock);
+
+	w->sent += n;
+	w->outSize[dest] = 0;
+}
+
+/* Send all the messages collected by the thread "tid". */
+void flushAllMessages(Hda *hda, int tid){
+	for (int dest = 0; dest < hda->numThreads; dest++)
+		flushMessages(hda, tid, dest);
+}
+
+/* Send a cell reached by the thread "tid" to its owner: the cells owned by "tid" itself are processed at once, the others are
+collected in the batch of their owner, which is sent when it is full. */
+void sendCell(Hda *hda, int tid, int dest, Message msg){
+	if (dest == tid) {
+		receiveCell(hda, tid, &msg);
+		return;
+	}
+	Worker *w = &hda->worker[tid];
+	w->out[(size_t)dest*MESSAGE_BATCH + w->outSize[dest]++] = msg;
+	if (w->outSize[dest] == MESSAGE_BATCH)
+		flushMessages(hda, tid, dest);
+}
+
+/* Process the messages in the inbox of the thread "tid" (the inbox is swapped with an empty buffer, so that it is locked only
+for a moment). It is returned true if there was at least a message. */
+bool receiveMessages(Hda *hda, int tid){
+	Worker *w = &hda->worker[tid];
+	Inbox *inbox = &hda->inbox[tid];
+	omp_set_lock(&inbox->lock);
+	Message *messages = inbox->messages;
+	int alloc = inbox->alloc;
+	int n = inbox->size;
+	if (n > 0) {
+		inbox->messages = w->received;
+		inbox->alloc = w->receivedAlloc;
+		inbox->size = 0;
+		w->received = messages;
+		w->receivedAlloc = alloc;
+	}
+	omp_unset_lock(&inbox->lock);
+	if (n == 0)
+		return false;
+
+	if (!w->active) {
+		#pragma omp atomic update
+		hda->work += 1;
+		w->active = true;
+	}
+	for (int i = 0; i < n; i++)
+		receiveCell(hda, tid, &w->received[i]);
+	#pragma omp atomic update
+	hda->work -= n;
+	return true;
+}
+
+/* Expansion of the best cell of the open set of the thread "tid": every free neighbor that may lead to a path shorter than the
+best one is sent to its owner. */
+void expandCell(Hda *hda, int tid, double mu){
+	Map *map = hda->map;
+	Worker *w = &hda->worker[tid];
+	int posC = openSetPop(&w->openSet);
+	int c[2] = {posC / map->cols, posC % map->cols};
+	w->expanded++;
+
+	for (int direction = 0; direction < CELL_DIRECTIONS; direction++) {
+		int neighbor[2] = {c[0] + cellDeltaRow[direction], c[1] + cellDeltaCol[direction]};
+		if (!check_position(map, neighbor) || !is_free(neighbor, map))
+			continue;
+		Message msg;
+		msg.pos = neighbor[0]*map->cols + neighbor[1];
+		msg.parent = (direction + CELL_DIRECTIONS/2) % CELL_DIRECTIONS;		// Direction from the neighbor to "c"
+		msg.g = hda->g[posC] + distance(c, neighbor);
+		if (msg.g + distance(neighbor, hda->goal) >= mu)
+			continue;
+		sendCell(hda, tid, owner(hda, neighbor[0], neighbor[1]), msg);
+	}
+}
+
+/* Work of the thread "tid": messages are received and cells are expanded until the search is over. */
+void runWorker(Hda *hda, int tid){
+	Worker *w = &hda->worker[tid];
+	int expansions = 0;
+	while (1) {
+		int failed;
+		double mu;
+		receiveMessages(hda, tid);
+		#pragma omp atomic read
+		failed = hda->failed;
+		if (failed)
+			return;
+		#pragma omp atomic read
+		mu = hda->mu;
+
+		if (w->openSet.size > 0 && openSetTopF(&w->openSet) < mu) {
+			expandCell(hda, tid, mu);
+			if (++expansions == FLUSH_EXPANSIONS) {
+				flushAllMessages(hda, tid);
+				expansions = 0;
+				sched_yield();		// With more threads than cores, the receivers get the chance to process the messages
+			}
+			continue;
+		}
+
+		// Nothing that can improve the best path: the messages collected are sent and the thread becomes idle
+		flushAllMessages(hda, tid);
+		expansions = 0;
+		if (w->active) {
+			#pragma omp atomic update
+			hda->work -= 1;
+			w->active = false;
+		}
+		long long work;
+		#pragma omp atomic read
+		work = hda->work;
+		if (work == 0)
+			return;
+		sched_yield();
+	}
+}
+
+/* Allocation of the state of the search with "numThreads" threads. It is returned false in case of failed allocation. */
+bool hdaInit(Hda *hda, Map *map, int numThreads, int goal[]){
+	int numCells = map->rows*map->cols;
+	memset(hda, 0, sizeof(Hda));
+	hda->map = map;
+	hda->numThreads = numThreads;
+	hda->goal[0] = goal[0];
+	hda->goal[1] = goal[1];
+	hda->posGoal = goal[0]*map->cols + goal[1];
+	hda->mu = INFINITY;
+	hda->work = numThreads;
+	hda->g = (double *)malloc((size_t)numCells*sizeof(double));
+	hda->parent = (unsigned char *)malloc((size_t)numCells*sizeof(unsigned char));
+	hda->inbox = (Inbox *)calloc(numThreads, sizeof(Inbox));
+	hda->worker = (Worker *)calloc(numThreads, sizeof(Worker));
+	if (hda->g == NULL || hda->parent == NULL || hda->inbox == NULL || hda->worker == NULL)
+		return false;
+
+	int i;
+	#pragma omp parallel for
+	for (i = 0; i < numCells; i++) {
+		hda->g[i] = INFINITY;
+		hda->parent[i] = PARENT_NONE;
+	}
+
+	for (int t = 0; t < numThreads; t++) {
+		Worker *w = &hda->worker[t];
+		Inbox *inbox = &hda->inbox[t];
+		omp_init_lock(&inbox->lock);
+		hda->numWorkers++;
+		w->active = true;
+		w->receivedAlloc = inbox->alloc = ALLOC;
+		w->received = (Message *)malloc(ALLOC*sizeof(Message));
+		inbox->messages = (Message *)malloc(ALLOC*sizeof(Message));
+		w->out = (Message *)malloc((size_t)numThreads*MESSAGE_BATCH*sizeof(Message));
+		w->outSize = (int *)calloc(numThreads, sizeof(int));
+		if (w->received == NULL || inbox->messages == NULL || w->out == NULL || w->outSize == NULL || !openSetInit(&w->openSet, numCells, ALLOC)) {
+			w->openSet.heap = NULL;
+			w->openSet.handle = NULL;
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Free the state of the search. */
+void hdaFree(Hda *hda){
+	for (int t = 0; t < hda->numWorkers; t++) {
+		Worker *w = &hda->worker[t];
+		omp_destroy_lock(&hda->inbox[t].lock);
+		openSetFree(&w->openSet);
+		free(w->received);
+		free(w->out);
+		free(w->outSize);
+		free(hda->inbox[t].messages);
+	}
+	free(hda->g);
+	free(hda->parent);
+	free(hda->inbox);
+	free(hda->worker);
+}
+
+/* Print the best path found, of length "length", in the file and in the format chosen on the command line (see
+"path-output.h"). */
+void printPath(double length, int bestPath[], int bestPathSize, Map *map, const PathOutput *output){
+	double deltaRow = bestPath[bestPathSize-1] / map->cols - bestPath[0] / map->cols;
+	double deltaCol = bestPath[bestPathSize-1] % map->cols - bestPath[0] % map->cols;
+	double minDistance = sqrt(deltaRow*deltaRow + deltaCol*deltaCol);
+	printf("\nGoal reached through %d intermedium cells. Path length %f over minimum distance %f (+ %.2f \%%).\n\n", bestPathSize-2, length, minDistance, ((length / minDistance) - 1)*100);
+	printf("Printing the path on the file... ");
+	if (!writePath(output, map, bestPath, bestPathSize)){
+		printf("Error while writing the output file %s.\n", output->fname);
+		exit(1);
+	}
+	printf("Path correctly printed on the file. ");
+	printf("File correctly closed.\n\n");
+}
+
+/* Backward path (from goal to start) following the parents from the goal point. Every parent has a lower value of "g" than
+its child, so the parents always lead to the starting point. The path is returned (NULL in case of failed allocation) and its
+number of cells is stored in "*pathSize". */
+int *hdaPath(Hda *hda, int *pathSize){
+	Map *map = hda->map;
+	int allocPath = ALLOC;
+	int *path = (int *)malloc(allocPath*sizeof(int));
+	int pos = hda->posGoal;
+	*pathSize = 0;
+	while (path != NULL) {
+		if (*pathSize >= allocPath) {
+			allocPath *= 2;
+			int *grown = (int *)realloc(path, allocPath*sizeof(int));
+			if (grown == NULL)
+				free(path);
+			path = grown;
+			if (path == NULL)
+				break;
+		}
+		path[(*pathSize)++] = pos;
+		if (hda->parent[pos] == PARENT_START)
+			break;
+		pos += cellDeltaRow[hda->parent[pos]]*map->cols + cellDeltaCol[hda->parent[pos]];
+	}
+	return path;
+}
+
+/* Search of the best path between "start" and "goal" with all the threads available, and printing of the result. */
+void search (Map *map, int start[], int goal[], const PathOutput *output) {
+	int numThreads = omp_get_max_threads();
+	Hda hda;
+	printf("Filling the cells... ");
+	if (!hdaInit(&hda, map, numThreads, goal)) {
+		printf("\nFailed allocation.\n");
+		hdaFree(&hda);
+		return;
+	}
+	printf("InitCells completed.\n");
+
+	// The starting cell is put in the open set of its owner
+	int posS = start[0]*map->cols + start[1];
+	hda.g[posS] = 0.0;
+	hda.parent[posS] = PARENT_START;
+	openSetPush(&hda.worker[owner(&hda, start[0], start[1])].openSet, posS, distance(start, goal));
+
+	printf("Searching the best path with %d threads...\n", numThreads);
+	struct timespec begin, end;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	#pragma omp parallel num_threads(numThreads)
+	{
+		if (omp_get_num_threads() == numThreads) {
+			runWorker(&hda, omp_get_thread_num());
+		} else {
+			#pragma omp single
+			{
+				printf("\n%d threads are not available.\n", numThreads);
+				#pragma omp atomic write
+				hda.failed = 1;
+			}
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+	long long expanded = 0, sent = 0;
+	for (int t = 0; t < numThreads; t++) {
+		expanded += hda.worker[t].expanded;
+		sent += hda.worker[t].sent;
+	}
+	printf("Search completed in %f s: %lld cells expanded, %lld messages sent between the threads.\n", seconds, expanded, sent);
+
+	if (hda.failed) {
+		printf("\nFailed allocation.\n");
+	} else if (hda.mu == INFINITY) {
+		printf("\nGoal not reachable!\n");
+	} else {
+		int pathSize;
+		int *path = hdaPath(&hda, &pathSize);
+		if (path == NULL)
+			printf("\nFailed allocation.\n");
+		else
+			printPath(hda.mu, path, pathSize, map, output);
+		free(path);
+	}
+	hdaFree(&hda);
+}
+
+/* Print how the program has to be launched. */
+void usage(const char *program){
+	printf("Usage: %s [-o grid|coords|runs|pgm] <map file> [<start row> <start col> <goal row> <goal col>]\n", program);
+	printf("The dimensions of the map are obtained from the map file. By default the starting point is the top right corner\n");
+	printf("of the map and the goal point is the bottom left one. The search uses OMP_NUM_THREADS threads. The option -o\n");
+	printf("selects the format of the output file (default: grid, i.e., the whole map with the path).\n");
+}
+
+int main (int argc, char *argv[]) {
+	PathOutput output;
+	output.format = OUTPUT_GRID;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "o:")) != -1) {
+		if (opt != 'o' || !parseOutputFormat(optarg, &output.format)) {
+			usage(argv[0]);
+			return 0;
+		}
+	}
+
+	int args = argc - optind;		// Number of arguments after the options
+	if (args != 1 && args != 5) {
+		usage(argv[0]);
+		return 0;
+	}
+
+	Map map;
+	if (!fillMap(&map, argv[optind])) {
+		return 0;
+	}
+	if (!mapFitsInt(&map)) {
+		freeMap(&map);
+		return 0;
+	}
+
+	int start[] = {0, map.cols-1};
+	int goal[] = {map.rows-1, 0};
+	if (args == 5) {
+		start[0] = atoi(argv[optind+1]);
+		start[1] = atoi(argv[optind+2]);
+		goal[0] = atoi(argv[optind+3]);
+		goal[1] = atoi(argv[optind+4]);
+	}
+
+	// Start and goal points assumed as always free
+	if (check_position(&map, start))
+		mapSetCell(&map, start[0], start[1], true);
+	if (check_position(&map, goal))
+		mapSetCell(&map, goal[0], goal[1], true);
+
+	pathFileName(argv[optind], output.format, output.fname, sizeof(output.fname));
+
+	if (!check(start, goal, &map)) {
+		freeMap(&map);
+		return 0;
+	}
+	search(&map, start, goal, &output);
+	freeMap(&map);
+	return 1;
+}
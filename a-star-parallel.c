@@ -5,38 +5,123 @@
 #include <time.h>
 #include <string.h>
 #include <omp.h>
+#include <unistd.h>
+#include <sched.h>
 
-#define DIM 500					// Dimension of rows and columns of the map
-#define OBSTACLES 10			// Percentage of obstacles in the map
-#define CONNECTIVITY 8			// Degree of freedom - must be 8
+#include "open-set.h"
+#include "closed-set.h"
+#include "cell-state.h"
+#include "map.h"
+#include "path-output.h"
+#include "jump-points.h"
+#include "hierarchy.h"
+#include "landmarks.h"
+#include "d-star-lite.h"
+#include "arena.h"
+#include "search-stats.h"
+#include "multi-queue.h"
+
+#define CONNECTIVITY 8			// Degree of freedom - 8 (straight and diagonal moves) or 4 (straight moves only)
 #define ALLOC 100				// Dimension used for dynamic vector allocation 
-#define ARR_MAX 2000			// Half of maximum dimension of an array to be printed (depends on the hardware)
+#define ARA_WEIGHT 3.0			// Default initial weight of the heuristic of the anytime search
+#define ARA_WEIGHT_STEP 0.5		// Decrease of the weight after every round of the anytime search
+#define ANYTIME_CHECK 256		// Cells expanded between two checks of the time budget of the anytime search (power of 2)
+#define REPLAN_ROUNDS 10		// Batches of random changes of the map in the replanning benchmark (option -k)
+#define REPLAN_SEED 0			// Seed of the pseudo-random generator of the random changes
+
+// Directions of the neighbors of a cell (see "cell-state.h") in the order of the bits of a walkability mask (see "map.h"): row
+// by row, as the previous double loop over deltaRow and deltaCol did. The neighbors are expanded from the lowest bit set up
+static const int neighborDirections[8] = {7, 0, 1, 6, 2, 5, 4, 3};
+#if CONNECTIVITY == 4
+#define NEIGHBOR_MASK 0x5A		// Bits of the moves allowed by the connectivity - N, W, E, S
+#else
+#define NEIGHBOR_MASK 0xFF
+#endif
+
+typedef enum {
+	ENGINE_ASTAR,				// Plain A* - every cell reached is expanded
+	ENGINE_JPS,					// Jump Point Search - only the jump points are expanded (see "jump-points.h")
+	ENGINE_HPA,					// Hierarchical search on the abstraction of the map (see "hierarchy.h")
+	ENGINE_BIDIR,				// Bidirectional A* - a forward and a backward search meeting in the middle
+	ENGINE_MQ,					// A* whose threads share a relaxed priority queue (see "multi-queue.h")
+	ENGINE_ARA					// Anytime weighted A* (ARA*) - a first path quickly, then better ones within a time budget
+} Engine;
+
+static const char *engineNames[] = {"astar", "jps", "hpa", "bidir", "mq", "ara"};
+
+/* Obtain the search engine from its name. It is returned false if the name is not valid. */
+bool parseEngine(const char *name, Engine *engine){
+	for (int i = 0; i < (int)(sizeof(engineNames) / sizeof(engineNames[0])); i++) {
+		if (strcmp(name, engineNames[i]) == 0) {
+			*engine = (Engine)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+typedef struct {
+	CellState cells;			// State of the cells of the map (see "cell-state.h")
+	OpenSet openSet;			// Open set (priority queue) - it contains all the cells that step by step will have to be considered
+	ClosedSet closedSet;		// Closed set - it contains all the cells already considered
+	int *path;					// Path between the starting point and the goal point
+	int *bestPath;				// Best path found
+	int allocPath;				// Number of elements allocated for "path"
+	int allocBestPath;			// Number of elements allocated for "bestPath"
+	int bestPathSize;			// Number of cells of "bestPath"
+	int cellOffset[CELL_DIRECTIONS];	// Offset of the neighbor in every direction in the vectors of the state of the cells
+	const Landmarks *landmarks;	// Landmarks of the heuristic (see "landmarks.h") - NULL if only the Euclidean distance is used
+	float target[LANDMARK_MAX];	// Distances of the point towards which the search is directed from the landmarks
+	int *incons;				// Inconsistent cells of the anytime search (see findPathAnytime()) - allocated when needed
+	int numIncons;				// Number of elements of "incons"
+	int allocIncons;			// Number of elements allocated for "incons"
+#if SEARCH_STATS
+	SearchStats stats;			// Statistics of the current search (see "search-stats.h") - those of the open set are kept in it
+#endif
+} SearchContext;
+
+typedef struct {
+	double weight;				// Initial weight of the heuristic
+	double epsilon;				// Suboptimality bound at which the search stops (1: only the shortest path)
+	double budget;				// Time budget of a search, in seconds (0: no limit)
+} AnytimeOptions;
 
 typedef struct {
-	int row, col;				// Row and column of a cell
-	double f;					// Total cost of a cell
-	double g;					// Distance (cost) between a cell and the starting point
-	double h;					// Heuristic - estimated distance (cost) between a cell and the goal point
-	int parentRow, parentCol;	// Row and column of the parent cell 
-} Cell;
+	double load;				// Reading of the map and building of the walkability grid or of the table of the masks
+	double init;				// Preparation of the search: abstraction of the map, landmarks, cells and jump distances
+	double search;				// Search of the path
+	double output;				// Writing of the output file
+} PhaseTimes;
+
+typedef struct {
+	int query[4];				// Row and column of the starting point, row and column of the goal point
+	int status;					// 1 = path found, 0 = goal not reachable, -1 = failed allocation, -2 = invalid query
+	double length;				// Length of the path
+	double bound;				// Suboptimality bound of the path - only for the anytime search (0 otherwise)
+	int *path;					// Cells of the path, from the goal point to the starting point
+	int pathSize;				// Number of cells of the path
+} BatchResult;
 
 /* Check if the values defined via the #define directives are correct. If they are, it is returned true, otherwise an error
 message is reported based on the first problem encountered and it is returned false.*/
 bool checkDefine(){
-	if (DIM <= 0){
-		printf("\n%d is not a valid dimension.\n", DIM);
-		return false;
-	} else if (CONNECTIVITY != 8){
+	if (CONNECTIVITY != 8 && CONNECTIVITY != 4){
 		printf("\n%d is not a valid connectivity.\n", CONNECTIVITY);
 		return false;
-	} else if (OBSTACLES < 0 || OBSTACLES > 100){
-		printf("\n%d is not a valid obstacle percentage.\n", OBSTACLES);
-		return false;
 	} else if (ALLOC <= 0){
 		printf("\n%d is not a valid value for reallocation.\n", ALLOC);
 		return false;
-	} else if (ARR_MAX <= 0){
-		printf("\n%d is not a valid string size for the printing.\n", ARR_MAX);
+	} else if (ARA_WEIGHT < 1.0 || ARA_WEIGHT_STEP <= 0.0){
+		printf("\n%f and %f are not a valid weight and step of the weight for the anytime search.\n", ARA_WEIGHT, ARA_WEIGHT_STEP);
+		return false;
+	} else if (REPLAN_ROUNDS <= 0){
+		printf("\n%d is not a valid number of rounds for the replanning benchmark.\n", REPLAN_ROUNDS);
+		return false;
+	} else if (ANYTIME_CHECK <= 0 || (ANYTIME_CHECK & (ANYTIME_CHECK - 1)) != 0){
+		printf("\n%d is not a valid interval for the checks of the time budget.\n", ANYTIME_CHECK);
+		return false;
+	} else if (OUT_BUFFER <= 0){
+		printf("\n%d is not a valid buffer size for the printing.\n", OUT_BUFFER);
 		return false;
 	} else {
 		return true;
@@ -44,16 +129,16 @@ bool checkDefine(){
 }
 
 /* Check if a cell is inside the map. If it is, it is returned true, otherwise false. */
-bool check_position (int cell[]) {
-	if (cell[0] >= 0 && cell[0] < DIM && cell[1] >= 0 && cell[1] < DIM)
+bool check_position (Map *map, int cell[]) {
+	if (cell[0] >= 0 && cell[0] < map->rows && cell[1] >= 0 && cell[1] < map->cols)
 		return true;
 	else
 		return false; 
 }
 
 /* Check if a cell is free or not. If it is, it is returned true, otherwise false. */
-bool is_free (int cell[], bool map[]) {
-	if (map[cell[0]*DIM+cell[1]] == true)
+bool is_free (int cell[], Map *map) {
+	if (mapIsFree(map, cell[0], cell[1]))
 		return true;
 	else
 		return false;
@@ -70,8 +155,8 @@ bool is_goal (int start[], int goal[]) {
 /* Check the correctness of the starting point and the goal point, i.e., if both are within the map, if they are free
 and if their positions do not coincide. If everything is ok, it is returned true, otherwise an error message is reported
 based on the first problem encountered and it is returned false. */
-bool check (int start[], int goal[], bool map[]) {
-	if (!(check_position(start) && check_position(goal))) {
+bool check (int start[], int goal[], Map *map) {
+	if (!(check_position(map, start) && check_position(map, goal))) {
 		printf("ERROR: start or goal point is out of the map!\n");
 		return false;
 	}
@@ -88,511 +173,1540 @@ bool check (int start[], int goal[], bool map[]) {
 	return true;
 }
 
-/* This function has the purpose of building the map, obtaining the values of interest from the "map-dim%d-obst%d" file
-present in the "maps" folder. This file contains several 0s and 1s, where the value 0 indicates that the cell is occupied
-(i.e., there is an obstacle), while the value 1 indicates that the cell is free. The function therefore tries to open the
-file for reading and, if it succeeds, inserts true values into the array map[] whenever it encounters 1s and false values
-whenever it encounters 0s. In case of an error in opening an error message is shown. */
-bool fillMap(bool map[], int start[], int goal[]){
-	printf("Opening file with DIM = %d and OBSTACLES = %d...\n", DIM, OBSTACLES);
+/* This function returns the position of a cell in the vectors of the state of the cells (see "cell-state.h"). */
+int calculatePos(Map *map, int cell[]){
+	return cell[0]*map->cols + cell[1];
+}
 
-	FILE *fp;
-	
-	int free_cell_num = 0, i = 0;
-	int c;
-	char fname[40];
-	sprintf(fname,"./maps/map-dim%d-obst%d",DIM,OBSTACLES);
-	
-	fp = fopen(fname,"r");
-	
-	if (fp == NULL){
-		printf("Error while opening the input file.\n");
-		exit(0);
-	} else {
-		printf("Filling map... ");
-		for(i=0; i<DIM*DIM; i++){
-			if(!feof(fp)){
-				fscanf(fp,"%d ",&c);
-				if(c){
-					map[i] = true;
-					free_cell_num++;
-				} else {
-					map[i] = false;
-				}
-			}
-		}
-		
-		// Start and goal points assumed as always free
-		map[start[0]*DIM+start[1]] = true;
-		map[goal[0]*DIM+goal[1]] = true;
-		
-		printf("Map %dx%d filled with %d free cells.\n", DIM, DIM, free_cell_num);
-		fclose(fp);
-		return 1;
-	}
+/* Initialization of every cell: all the cells are marked as not reached (they are initialized only when the search reaches
+them, see "cell-state.h") and the starting cell is initialized. */
+void initCells(CellState *cells, Map *map, int start[], int goal[]){	
+	cellStateReset(cells, map->rows*map->cols);
+
+	// Initialization of the starting cell
+	int posS = calculatePos(map, start);
+	cellTouch(cells, posS);
+	cells->g[posS] = 0.0;
+	cells->parent[posS] = PARENT_START;
+	if (cells->jumpParent != NULL)
+		cells->jumpParent[posS] = posS;
 }
 
-/* This function returns the position of a cell in the vector "arrayCells[]" used in the "search()" function. */
-int calculatePos(int cell[]){
-	return cell[0]*DIM + cell[1];
+/* This function returns the Euclidean distance between two cells. */
+double distance (int a[], int b[]) {
+	double deltaRow = a[0] - b[0], deltaCol = a[1] - b[1];		// In double, since the squares may not fit in an int
+	return sqrt(deltaRow*deltaRow + deltaCol*deltaCol);
 }
 
-/* Initialization of every cell. */
-void initCells(Cell arrayCells[], int start[], int goal[]){	
-	int i,j,pos;
-	for (i = 0; i < DIM; i++) {
-		for (j = 0; j < DIM; j++) {
-			pos = i*DIM + j;
-			arrayCells[pos].row = i;
-			arrayCells[pos].col = j;
-			arrayCells[pos].f = 200000.0;		// Very high number
-			arrayCells[pos].g = 100000.0;		// Very high number
-			arrayCells[pos].h = 100000.0;		// Very high number
-			arrayCells[pos].parentRow = -1;		// Invalid position
-			arrayCells[pos].parentCol = -1;		// Invalid position
-		}
+/* This function returns the heuristic of a cell, i.e., the estimate of its distance from the point "target" towards which the
+search of the context "ctx" is directed: the Euclidean distance, or the landmark bound if it is higher. */
+double heuristic(const SearchContext *ctx, Map *map, int cell[], int target[]) {
+	double h = distance(cell, target);
+	if (ctx->landmarks != NULL) {
+		double bound = landmarkBound(ctx->landmarks, ctx->target, calculatePos(map, cell));
+		if (bound > h)
+			h = bound;
 	}
-	printf("InitCells completed.\n");
-
-	// Initialization of the starting cell
-	int posS = calculatePos(start);
-	arrayCells[posS].f = 0.0;
-	arrayCells[posS].g = 0.0;
-	arrayCells[posS].h = 0.0;
-	arrayCells[posS].parentRow = start[0];
-	arrayCells[posS].parentCol = start[1];
+	return h;
 }
 
-/* This function returns the Euclidean distance between two cells. */
-double distance (Cell a, Cell b) {
-	return ((double)sqrt((a.row - b.row)*(a.row - b.row) + (a.col - b.col)*(a.col - b.col)));
+/* Compute the offsets of the neighbors of a cell in every direction in the vectors of the state of the cells. */
+void neighborOffsets(Map *map, int cellOffset[]){
+	for (int direction = 0; direction < CELL_DIRECTIONS; direction++)
+		cellOffset[direction] = cellDeltaRow[direction]*map->cols + cellDeltaCol[direction];
 }
 
-/* Check if a neighbor is valid (i.e., if it is inside the map) and free. If it is, it is returned true, otherwise false. */
-bool check_a_neighbor(int deltaRow, int deltaCol, int cell[], bool map[]){
-	int neighbor[2];
-	neighbor[0] = cell[0] + deltaRow;
-	neighbor[1] = cell[1] + deltaCol;
-	if((check_position(neighbor)) && (is_free(neighbor, map)))
-		return true;
-	else
-		return false;
+/* Return the free neighbors of the cell (r, c), whose position is "pos", as a walkability mask (see "map.h") restricted to the
+moves allowed by the connectivity: it is read from the table of the masks if it was built (option -m), otherwise it is
+obtained from the walkability grid. Thanks to the border of the grid, no bounds check is needed in either case. */
+static inline unsigned int freeNeighbors(Map *map, int pos, int r, int c){
+	return (map->mask != NULL ? map->mask[pos] : mapWalkMask(map, r, c)) & NEIGHBOR_MASK;
 }
 
 /* Evaluation of the best parent (in terms of g) for the cell thisCell[]. */
-int chooseBestParent(Cell arrayCells[], bool map[], int thisCell[], int bestParent[]){
-	int thisCellPos = calculatePos(thisCell);
-	int deltaRow, deltaCol;
-	int bpPos = calculatePos(bestParent);					
-	int currentParent[2];
-	int cpPos;
-	for (deltaRow=-1; deltaRow<=1; deltaRow++){
-		for (deltaCol=-1; deltaCol<=1; deltaCol++){
-			if (deltaRow != 0 || deltaCol != 0){	// This excludes the cell itself from the evaluation	
-				if (check_a_neighbor(deltaRow, deltaCol, thisCell, map)) {
-					currentParent[0] = thisCell[0]+deltaRow;
-					currentParent[1] = thisCell[1]+deltaCol;
-					cpPos = calculatePos(currentParent);
-					if(arrayCells[cpPos].g < arrayCells[bpPos].g){
-						bestParent[0] = currentParent[0];
-						bestParent[1] = currentParent[1];
-						bpPos = calculatePos(bestParent);
-						arrayCells[thisCellPos].parentRow = currentParent[0];
-						arrayCells[thisCellPos].parentCol = currentParent[1];
-					}
-				}
-			}
+int chooseBestParent(SearchContext *ctx, Map *map, int thisCell[], int bestParent[]){
+	CellState *cells = &ctx->cells;
+	int thisCellPos = calculatePos(map, thisCell);
+	int bpPos = calculatePos(map, bestParent);					
+	for (unsigned int mask = freeNeighbors(map, thisCellPos, thisCell[0], thisCell[1]); mask != 0; mask &= mask - 1) {
+		int direction = neighborDirections[__builtin_ctz(mask)];
+		int cpPos = thisCellPos + ctx->cellOffset[direction];
+		if (cellG(cells, cpPos) < cellG(cells, bpPos)) {
+			bestParent[0] = thisCell[0] + cellDeltaRow[direction];
+			bestParent[1] = thisCell[1] + cellDeltaCol[direction];
+			bpPos = cpPos;
+			cells->parent[thisCellPos] = direction;
 		}
 	}
 	return bpPos;
 }
 
-/* Print the best path found. */
-void printPath(Cell arrayCells[], int bestPath[], int bestPathSize, bool map[]){
-	printf("\nGoal reached through %d intermedium cells. Path length %f over minimum distance %f (+ %.2f \%%).\n\n", bestPathSize-2, arrayCells[bestPath[0]].f, distance(arrayCells[bestPath[bestPathSize-1]], arrayCells[bestPath[0]]), ((arrayCells[bestPath[0]].f / distance(arrayCells[bestPath[bestPathSize-1]], arrayCells[bestPath[0]])) - 1)*100);
-	int ripet = DIM / ARR_MAX;
-	int remain = DIM % ARR_MAX;
-	int r,c,n;
-	char *row = malloc(2*ARR_MAX*sizeof(bool));
-	
-	FILE *fp;
-	
-	char fname[40];
-	sprintf(fname,"./paths/path-dim%d-obst%d",DIM,OBSTACLES);
-	
-	fp = fopen(fname,"w");
-	if (fp == NULL){
-		printf("Error while opening the output file.\n");
-		exit(1);
-	} else {
-		printf("Printing the path on the file... ");
-		
-		for (r=0; r<DIM; r++){
-			for (n=0; n<ripet; n++){
-				for (c=0; c<ARR_MAX; c+=1){
-					int posCell = r*DIM+n*ARR_MAX+c;
-					if (!map[posCell]){
-						row[2*c] = 'X';
-					} else {
-						bool isPath = false;
-						for (int b=0; b<bestPathSize; b++){
-							if(arrayCells[posCell].row == arrayCells[bestPath[b]].row && arrayCells[posCell].col == arrayCells[bestPath[b]].col)
-								isPath = true;
-						}
-						if(isPath){
-							if(arrayCells[posCell].row == arrayCells[bestPath[0]].row && arrayCells[posCell].col == arrayCells[bestPath[0]].col){
-								row[2*c] = 'G';		// Goal point
-							} else if(arrayCells[posCell].row == arrayCells[bestPath[bestPathSize-1]].row && arrayCells[posCell].col == arrayCells[bestPath[bestPathSize-1]].col){
-								row[2*c] = 'S';		// Starting point
-							} else row[2*c] = 'O';	// Point of the path
-						} else
-							row[2*c] = '.';			// Free
-					}
-					row[2*c+1] = ' ';
-				}
-				row[2*ARR_MAX] = '\0';
-				fprintf(fp, "%s", row);
-			}
-			for (c=0; c<remain; c++){
-				int posCell = r*DIM+n*ARR_MAX+c;
-				if (!map[posCell]){
-					row[2*c] = 'X';
-				} else {
-					bool isPath = false;
-					for (int b=0; b<bestPathSize; b++){
-						if(arrayCells[posCell].row == arrayCells[bestPath[b]].row && arrayCells[posCell].col == arrayCells[bestPath[b]].col)
-							isPath = true;
-					}
-					if(isPath){
-						if(arrayCells[posCell].row == arrayCells[bestPath[0]].row && arrayCells[posCell].col == arrayCells[bestPath[0]].col){
-							row[2*c] = 'G';		// Goal point
-						} else if(arrayCells[posCell].row == arrayCells[bestPath[bestPathSize-1]].row && arrayCells[posCell].col == arrayCells[bestPath[bestPathSize-1]].col){
-							row[2*c] = 'S';		// Starting point
-						} else row[2*c] = 'O';	// Point of the path
-					} else
-						row[2*c] = '.';			// Free
-				}
-				row[2*c+1] = ' ';
-			}
-			row[2*remain] = '\0';
-			fprintf(fp, "%s\n", row);
+/* Number of cells of the path found by Jump Point Search, from the goal point back to the starting point. Consecutive jump
+points of the path are joined by a straight or diagonal segment, whose cells are counted too. */
+int jumpPathSize(CellState *cells, Map *map, int posGoal){
+	int size = 1;
+	int pos = posGoal;
+	while (cells->jumpParent[pos] != pos) {
+		int parent = cells->jumpParent[pos];
+		int deltaRow = abs(parent / map->cols - pos / map->cols);
+		int deltaCol = abs(parent % map->cols - pos % map->cols);
+		size += (deltaRow > deltaCol) ? deltaRow : deltaCol;
+		pos = parent;
+	}
+	return size;
+}
+
+/* Backward path (from goal to start) found by Jump Point Search: the parents of the jump points are followed from the goal
+point and the cells of the segments between them are filled in. "path[]" must have room for jumpPathSize() cells. */
+void jumpPath(CellState *cells, Map *map, int posGoal, int path[]){
+	int pathSize = 0;
+	int pos = posGoal;
+	path[pathSize++] = pos;
+	while (cells->jumpParent[pos] != pos) {
+		int row = pos / map->cols, col = pos % map->cols;
+		int parentRow = cells->jumpParent[pos] / map->cols, parentCol = cells->jumpParent[pos] % map->cols;
+		int stepRow = (parentRow > row) - (parentRow < row);
+		int stepCol = (parentCol > col) - (parentCol < col);
+		while (row != parentRow || col != parentCol) {
+			row += stepRow;
+			col += stepCol;
+			path[pathSize++] = row*map->cols + col;
 		}
-		
-		printf("Path correctly printed on the file. ");
-		fclose(fp);
-		printf("File correctly closed.\n\n");
+		pos = cells->jumpParent[pos];
+	}
+}
+
+/* Expansion of the current cell "c" for Jump Point Search: its successors are the next jump points along the directions that
+are not pruned (see "jump-points.h"). Unlike the plain A* expansion, the parent of a successor is changed only when the
+successor is reached with a lower cost, since the path is rebuilt following the parents. "bestF" is the value of "f" of the
+best path found so far (if any). It is returned false in case of failed allocation. */
+bool expandJumpPoints(SearchContext *ctx, Map *map, JumpTable *jumps, int c[], int goal[], bool foundPath, double bestF){
+	CellState *cells = &ctx->cells;
+	OpenSet *openSet = &ctx->openSet;
+	int posC = calculatePos(map, c);
+
+	// Direction along which the current cell has been reached (none for the starting point, whose parent is the cell itself)
+	int arrival = -1;
+	int parentRow = cells->jumpParent[posC] / map->cols, parentCol = cells->jumpParent[posC] % map->cols;
+	if (parentRow != c[0] || parentCol != c[1])
+		arrival = jumpDirection((c[0] > parentRow) - (c[0] < parentRow), (c[1] > parentCol) - (c[1] < parentCol));
+
+	int succ[JUMP_DIRECTIONS];
+	double cost[JUMP_DIRECTIONS];
+	int numSucc = jumpSuccessors(jumps, map, c[0], c[1], arrival, goal[0], goal[1], succ, cost);
+
+	for (int i = 0; i < numSucc; i++) {
+		int posN = succ[i];
+		if (closedSetContains(&ctx->closedSet, posN))
+			continue;
+		int n[2] = {posN / map->cols, posN % map->cols};
+		double tmpG = cells->g[posC] + cost[i];
+		double h = heuristic(ctx, map, n, goal);
+		bool inOpenSet = openSetContains(openSet, posN);
+		if (inOpenSet ? tmpG >= cells->g[posN] : (foundPath && tmpG + h >= bestF))
+			continue;
+
+		cellTouch(cells, posN);
+		cells->g[posN] = tmpG;
+		cells->jumpParent[posN] = posC;
+		if (inOpenSet)
+			openSetDecreaseKey(openSet, posN, tmpG + h);
+		else if (!openSetPush(openSet, posN, tmpG + h))
+			return false;
 	}
-	free(row);
+	return true;
+}
+
+/* Print the best path found, of length "length", in the file and in the format chosen on the command line (see
+"path-output.h"). */
+void printPath(double length, int bestPath[], int bestPathSize, Map *map, const PathOutput *output){
+	double deltaRow = bestPath[bestPathSize-1] / map->cols - bestPath[0] / map->cols;
+	double deltaCol = bestPath[bestPathSize-1] % map->cols - bestPath[0] % map->cols;
+	double minDistance = sqrt(deltaRow*deltaRow + deltaCol*deltaCol);
+	printf("\nGoal reached through %d intermedium cells. Path length %f over minimum distance %f (+ %.2f \%%).\n\n", bestPathSize-2, length, minDistance, ((length / minDistance) - 1)*100);
+	printf("Printing the path on the file... ");
+	if (!writePath(output, map, bestPath, bestPathSize)){
+		printf("Error while writing the output file %s.\n", output->fname);
+		exit(1);
+	}
+	printf("Path correctly printed on the file. ");
+	printf("File correctly closed.\n\n");
 }
 
 /* This function explicits the result of the search, i.e., if a path is found, then it is printed, otherwise a message
 is printed that warns of the unreachability of the goal point. */ 
-void endSearch(bool foundPath, Cell arrayCells[], int bestPath[], int bestPathSize, bool map[], int posStart, int posGoal) {
+void endSearch(bool foundPath, double length, int bestPath[], int bestPathSize, Map *map, int posStart, int posGoal, const PathOutput *output) {
 	if(foundPath) {
-		printPath(arrayCells, bestPath, bestPathSize, map);
+		printPath(length, bestPath, bestPathSize, map, output);
 	} else {
 		printf("\nGoal not reachable!\n");
 	}
 }
 
-/* Free all dynamic vectors. */
-void freeAll(int openSet[], int closedSet[], int path[], int bestPath[]){
-	free(openSet);
-	free(closedSet);
-	free(path);
-	free(bestPath);
+/* Allocation of the vectors used by a search on the map with the engine "engine" and the landmarks "landmarks" (NULL if they
+are not used). The same context can be used for any number of searches on the map, each one prepared by resetSearch(). It is
+returned false in case of failed allocation. */
+bool searchContextInit(SearchContext *ctx, Map *map, Engine engine, const Landmarks *landmarks){
+	ctx->landmarks = landmarks;
+	neighborOffsets(map, ctx->cellOffset);
+	int numCells = map->rows*map->cols;
+	bool cellsOk = cellStateInit(&ctx->cells, numCells, engine == ENGINE_JPS);
+	ctx->allocPath = ctx->allocBestPath = map->rows + map->cols;		// Enough for most of the paths, otherwise doubled
+	ctx->path = (int*)malloc(sizeof(int)*ctx->allocPath);
+	ctx->bestPath = (int*)malloc(sizeof(int)*ctx->allocBestPath);
+	ctx->bestPathSize = 0;
+	ctx->incons = NULL;
+	ctx->numIncons = 0;
+	ctx->allocIncons = 0;
+	bool openSetOk = openSetInit(&ctx->openSet, numCells, 2*(map->rows + map->cols));
+	bool closedSetOk = closedSetInit(&ctx->closedSet, numCells);
+
+	// Check if the allocation is done correctly 
+	if (!cellsOk || ctx->path == NULL || ctx->bestPath == NULL || !openSetOk || !closedSetOk) {
+		if (cellsOk)
+			cellStateFree(&ctx->cells);
+		if (openSetOk)
+			openSetFree(&ctx->openSet);
+		if (closedSetOk)
+			closedSetFree(&ctx->closedSet);
+		free(ctx->path);
+		free(ctx->bestPath);
+		return false;
+	}
+	return true;
 }
 
-/* Main part of the algorithm - here all operations are carried out to find the best path. */
-void search (bool map[], int start[], int goal[]) {	
-	printf("Filling arrayCells... ");
-	Cell *arrayCells;
-	arrayCells = (Cell *)malloc(DIM*DIM*sizeof(Cell));
+/* Free all dynamic vectors of a search context. */
+void searchContextFree(SearchContext *ctx){
+	openSetFree(&ctx->openSet);
+	closedSetFree(&ctx->closedSet);
+	cellStateFree(&ctx->cells);
+	free(ctx->path);
+	free(ctx->bestPath);
+	free(ctx->incons);
+}
 
-	// Check if the allocation is done correctly 
-	if(arrayCells == NULL) {
+/* Allocation of "num" search contexts (see searchContextInit()). In case of failed allocation none of them is left allocated
+and it is returned false. */
+bool searchContextsInit(SearchContext ctx[], int num, Map *map, Engine engine, const Landmarks *landmarks){
+	for (int i = 0; i < num; i++) {
+		if (!searchContextInit(&ctx[i], map, engine, landmarks)) {
+			while (--i >= 0)
+				searchContextFree(&ctx[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Free "num" search contexts. */
+void searchContextsFree(SearchContext ctx[], int num){
+	for (int i = 0; i < num; i++)
+		searchContextFree(&ctx[i]);
+}
+
+/* Preparation of a search context for a new search between "start" and "goal": the cells are initialized, the open set and
+the closed set are emptied and the distances of the goal point from the landmarks are copied. The cost does not depend on the
+size of the map (see "cell-state.h" and "closed-set.h"). */
+void resetSearch(SearchContext *ctx, Map *map, int start[], int goal[]){
+	initCells(&ctx->cells, map, start, goal);
+	if (ctx->landmarks != NULL)
+		landmarkTarget(ctx->landmarks, calculatePos(map, goal), ctx->target);
+	openSetClear(&ctx->openSet);
+	closedSetClear(&ctx->closedSet);
+	ctx->bestPathSize = 0;
+	STATS(memset(&ctx->stats, 0, sizeof(ctx->stats)));
+}
+
+#if SEARCH_STATS
+/* Print the statistics of the search between "start" and "goal" done with the engine "engine" (see "search-stats.h"): those of
+the contexts "ctx" ("num" of them, none if the search has not used any) and of their open sets and closed sets are summed with
+"extra" (if not NULL, e.g., the allocation of an arena), the times of the phases are taken from "times" (whose search time
+includes the reconstruction of the path). */
+void searchStatsReport(SearchContext ctx[], int num, const SearchStats *extra, Engine engine, int start[], int goal[], int found, double length, const PhaseTimes *times){
+	SearchStats stats;
+	memset(&stats, 0, sizeof(stats));
+	if (extra != NULL)
+		searchStatsAdd(&stats, extra);
+	for (int i = 0; i < num; i++) {
+		SearchStats own = ctx[i].stats;
+		own.pushes = ctx[i].openSet.pushes;
+		own.pops = ctx[i].openSet.pops;
+		own.decreaseKeys = ctx[i].openSet.decreaseKeys;
+		own.peakOpen = ctx[i].openSet.peak;
+		own.openReallocs = ctx[i].openSet.reallocs;
+		own.allocations = own.vectorReallocs + own.openReallocs;
+		own.allocTime += ctx[i].openSet.reallocTime;
+		if (ctx[i].closedSet.size > own.peakClosed)
+			own.peakClosed = ctx[i].closedSet.size;
+		searchStatsAdd(&stats, &own);
+	}
+	stats.fillMap = times->load;
+	stats.initCells = times->init;
+	stats.search = times->search - stats.reconstruction;
+	stats.printPath = times->output;
+	int query[4] = {start[0], start[1], goal[0], goal[1]};
+	searchStatsPrint(&stats, engineNames[engine], query, found, length);
+}
+#endif
+
+/* Return the time of the monotonic clock, in seconds. */
+double monotonicTime(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* Make room for "size" elements in the vector "*v" of the search context "ctx", which has "*alloc" elements, + possible
+reallocation. The vector grows at least to twice its size, so that a vector filled one element at a time is copied O(1) times
+per element. It is returned false in case of failed allocation. */
+bool reserveVector(SearchContext *ctx, int **v, int *alloc, int size){
+	if (size <= *alloc)
+		return true;
+#if SEARCH_STATS
+	double begin = monotonicTime();
+#else
+	(void)ctx;
+#endif
+	int grown = (2*(*alloc) > size) ? 2*(*alloc) : size;
+	if (grown < ALLOC)
+		grown = ALLOC;
+	int *data = (int *)realloc(*v, (size_t)grown*sizeof(int));
+	if (data == NULL)
+		return false;
+	*v = data;
+	*alloc = grown;
+	STATS(ctx->stats.vectorReallocs++; ctx->stats.allocTime += monotonicTime() - begin);
+	return true;
+}
+
+/* Search on the abstraction of the map (HPA*, see "hierarchy.h"): the abstract graph is searched and its path is refined into
+the cells of the map. The path found is near-optimal. It is returned false if the abstract graph does not connect the starting
+point and the goal point (it only crosses the borders of the clusters with straight moves), so that the plain A* search can
+decide whether the goal point is reachable. The time of the search and of the output is added to "times". */
+bool searchHierarchy(Map *map, Hierarchy *hierarchy, int start[], int goal[], PhaseTimes *times, const PathOutput *output){
+	int *path;
+	int pathSize;
+	double length;
+
+	printf("Searching the abstract graph...\n");
+	double begin = monotonicTime();
+	Arena arena;		// Scratch memory of the search, allocated and freed in one step
+	int found = arenaInit(&arena, hierarchySearchBytes(hierarchy)) ? 0 : -1;
+#if SEARCH_STATS
+	SearchStats stats;
+	memset(&stats, 0, sizeof(stats));
+	stats.allocations = 1;
+	stats.allocTime = monotonicTime() - begin;
+#endif
+	if (found == 0) {
+		found = hierarchySearch(hierarchy, map, &arena, calculatePos(map, start), calculatePos(map, goal), &path, &pathSize, &length);
+		arenaFree(&arena);
+	}
+	times->search += monotonicTime() - begin;
+	if (found < 0) {
 		printf("\nFailed allocation.\n");
-		return;
+		return true;
+	} else if (found == 0) {
+		printf("The abstract graph does not connect the starting point and the goal point.\n");
+		return false;
 	}
+	begin = monotonicTime();
+	printPath(length, path, pathSize, map, output);
+	times->output += monotonicTime() - begin;
+	STATS(searchStatsReport(NULL, 0, &stats, ENGINE_HPA, start, goal, 1, length, times));
+	free(path);
+	return true;
+}
 
-	// Initialization of each cell
-	initCells(arrayCells, start, goal);
-	
-	int posS = calculatePos(start);
-	int posG = calculatePos(goal);
+/* Main part of the algorithm - here all operations are carried out to find the best path between "start" and "goal", with
+the context "ctx" prepared by resetSearch() (and the jump distances "jumps" for Jump Point Search). The best path found is left
+in ctx->bestPath. It is returned 1 if a path has been found, 0 if the goal point is not reachable and -1 in case of failed
+allocation. */ 
+int findPath (SearchContext *ctx, Map *map, int start[], int goal[], Engine engine, JumpTable *jumps) {	
+	CellState *cells = &ctx->cells;
+	int posS = calculatePos(map, start);
 
-	// Initialization of 4 vectors, i.e., openSet, closedSet, path, bestPath
-	
-	int *openSet;			// Open set (priority queue) - it contains all the cells that step by step will have to be considered 
-	int allocOpen = ALLOC;
-	openSet = (int*)malloc(sizeof(int)*allocOpen);
-	openSet[0] = posS;		// The first cell in the open set is the starting cell
-	int openSetSize = 1;
-
-	int *closedSet;			// Closed set - it contains all the cells already considered 
-	int allocClosed = ALLOC;
-	closedSet = (int*)malloc(sizeof(int)*allocClosed);
-	int closedSetSize = 0;
+	openSetPush(&ctx->openSet, posS, 0.0);	// The first cell in the open set is the starting cell
 	
 	bool foundPath = false;
-	
-	int *path;				// Path between the starting point and the goal point
-	int allocPath = ALLOC;
-	path = (int*)malloc(sizeof(int)*allocPath);
 	int pathSize = 0;
-	
-	int *bestPath;
-	bestPath = (int*)malloc(sizeof(int)*allocPath);
-	int bestPathSize = 0;
-
-	printf("Searching the best path...\n");
-	
-//	double somma_time = 0, tot_time = 0, s1 = 0, e1 = 0, t1 = 0, s2 = 0, e2 = 0, t2 = 0;
-//	double start_time, st, et, end_time;
 
 	while (1) {
 		int c[2];		// "c" is the current cell
-		bool isThereBest = false;
-		int best = 0;	// Initial assumption: the cell having the lowest value of "f" is in the first position of the "openSet"
-		
-		// Scan the "openSet" to find the new best cell		
-		for (int i = 0; i < openSetSize; i++) {
-		    double tmpF = arrayCells[openSet[i]].f;
-	    	if (tmpF <= arrayCells[openSet[best]].f) {
-				if ((foundPath && tmpF <= arrayCells[bestPath[0]].f) || !foundPath){
-					isThereBest = true;
-					best = i;
-				}
-			}
-		}
 
-		// Condition that terminates the algorithm 		
-		if((foundPath && !isThereBest) || openSetSize == 0){
-			endSearch(foundPath, arrayCells, bestPath, bestPathSize, map, posS, posG);
-			freeAll(openSet, closedSet, path, bestPath);
-			return;
+		// Condition that terminates the algorithm: the open set is empty or even its best cell can not improve the path found
+		if(ctx->openSet.size == 0 || (foundPath && openSetTopF(&ctx->openSet) >= cells->g[ctx->bestPath[0]])){
+			return foundPath ? 1 : 0;
 		}
-		
-		c[0] = arrayCells[openSet[best]].row;
-		c[1] = arrayCells[openSet[best]].col;
-				
-		int posC = calculatePos(c);		
-		if(posC == posS){
-			arrayCells[posS].h = distance(arrayCells[posS], arrayCells[posG]);
-			arrayCells[posS].f = arrayCells[posS].h;
-		}
-				
-		// Remove the current cell from the "openSet"
-		for (int i = best; i < openSetSize; i++) {
-			openSet[i] = openSet[i+1];
-		}
-		openSetSize--;
-		
-		// Add the current cell inside the closed set + possible reallocation of "closedSet" vector
-		if(closedSetSize >= allocClosed){
-			allocClosed += ALLOC;
-			closedSet = (int*)realloc(closedSet, allocClosed*sizeof(int));
-		}
-		
-		closedSet[closedSetSize] = posC;
-		closedSetSize++;
+
+		// Remove the cell having the lowest value of "f" from the "openSet", i.e., the new best cell
+		int posC = openSetPop(&ctx->openSet);
+		c[0] = posC / map->cols;
+		c[1] = posC % map->cols;
+
+		// Add the current cell inside the closed set
+		closedSetAdd(&ctx->closedSet, posC);
+		STATS(ctx->stats.expanded++);
 				
 		if (is_goal(c, goal)) {					// Check whether the current cell is the goal point or not
-			int thisCell[2] = {c[0], c[1]};		// thisCell = c
-			int thisCellPos = posC;
+#if SEARCH_STATS
+			double reconstructionBegin = monotonicTime();
+#endif
+			if (engine == ENGINE_JPS) {
+				// The path is rebuilt following the parents of the jump points
+				pathSize = jumpPathSize(cells, map, posC);
+				if (!reserveVector(ctx, &ctx->path, &ctx->allocPath, pathSize))
+					return -1;
+				jumpPath(cells, map, posC, ctx->path);
+			} else {
+				int thisCell[2] = {c[0], c[1]};		// thisCell = c
+				int thisCellPos = posC;
 							
-			path[0] = thisCellPos;				// Backward path (from goal to start)
-			pathSize = 1;
+				ctx->path[0] = thisCellPos;				// Backward path (from goal to start)
+				pathSize = 1;
 			
-			// These instructions are executed every time a cell has a parent (the loop stops when the starting cell is evaluated, whose parent is the cell itself) 
-			while ((arrayCells[thisCellPos].parentRow != -1) && (arrayCells[thisCellPos].row != arrayCells[thisCellPos].parentRow || arrayCells[thisCellPos].col != arrayCells[thisCellPos].parentCol)) {
+				// These instructions are executed every time a cell has a parent (the loop stops when the starting cell is evaluated, whose parent is the cell itself) 
+				while (cellParent(cells, thisCellPos) != PARENT_NONE && cellParent(cells, thisCellPos) != PARENT_START) {
 				
-				// Possible reallocation of "path" and "bestPath" vectors 
-				if(pathSize >= allocPath){
-					allocPath += ALLOC;
-					path = (int*)realloc(path, allocPath*sizeof(int));
-					bestPath = (int*)realloc(bestPath, allocPath*sizeof(int));
-				}
+					// Possible reallocation of the "path" vector
+					if (!reserveVector(ctx, &ctx->path, &ctx->allocPath, pathSize + 1))
+						return -1;
 				
-				// Choose the best parent for "thisCell"
-				int bestParent[2] = {arrayCells[thisCellPos].parentRow, arrayCells[thisCellPos].parentCol};
-				int bpPos = chooseBestParent(arrayCells, map, thisCell, bestParent);
+					// Choose the best parent for "thisCell"
+					int direction = cells->parent[thisCellPos];
+					int bestParent[2] = {thisCell[0] + cellDeltaRow[direction], thisCell[1] + cellDeltaCol[direction]};
+					int bpPos = chooseBestParent(ctx, map, thisCell, bestParent);
 				
-				// "thisCell" is updated to the best parent
-				thisCellPos = bpPos;
-				bestParent[0] = arrayCells[bpPos].row;
-				bestParent[1] = arrayCells[bpPos].col;
-				thisCell[0] = bestParent[0];
-				thisCell[1] = bestParent[1];
+					// "thisCell" is updated to the best parent
+					thisCellPos = bpPos;
+					thisCell[0] = bestParent[0];
+					thisCell[1] = bestParent[1];
 				
-				path[pathSize] = bpPos;			// Add the parent cell to the path
-				pathSize++;
+					ctx->path[pathSize] = bpPos;			// Add the parent cell to the path
+					pathSize++;
+				}
 			}
 			
-			// Updates "bestPath" if it is the first path found or if the new path is better than the previous one 
-			if(!foundPath || (foundPath && arrayCells[path[0]].f < arrayCells[bestPath[0]].f)) {
-				for(int i = 0; i < pathSize; i++){
-					bestPath[i] = path[i];
-				}
-				bestPathSize = pathSize;
+			// Updates "bestPath" if it is the first path found or if the new path is better than the previous one: the two vectors
+			// are swapped, so that the path is not copied
+			if(!foundPath || (foundPath && cells->g[ctx->path[0]] < cells->g[ctx->bestPath[0]])) {
+				int *swapPath = ctx->bestPath, swapAlloc = ctx->allocBestPath;
+				ctx->bestPath = ctx->path;
+				ctx->allocBestPath = ctx->allocPath;
+				ctx->path = swapPath;
+				ctx->allocPath = swapAlloc;
+				ctx->bestPathSize = pathSize;
 			}
 			
 			foundPath = true;
+			STATS(ctx->stats.reconstruction += monotonicTime() - reconstructionBegin);
 
-			float pathF = arrayCells[bestPath[0]].f;
-			for(int i = 0; i < openSetSize; i++){
-				if (arrayCells[openSet[i]].f >= pathF){
-					
-					// Possible reallocation of "closedSet" vector
-					if(closedSetSize >= allocClosed){
-						allocClosed += ALLOC;
-						closedSet = (int*)realloc(closedSet, allocClosed*sizeof(int));
-					}		
-
-					// Add the cell to the "closedSet"
-					closedSet[closedSetSize] = openSet[i];
-					closedSetSize++;
-					
-					for (int j = i; j < openSetSize; j++){					
-						// remove the cell from the OpenSet
-						openSet[j] = openSet[j+1];
-					}
-					openSetSize--;
-				}
-			}
+			// The remaining cells of the "openSet" are not removed: the search stops as soon as the best one of them has a value of
+			// "f" not lower than the one of the path found
+		}
+
+		if (engine == ENGINE_JPS) {
+			if (!expandJumpPoints(ctx, map, jumps, c, goal, foundPath, foundPath ? cells->g[ctx->bestPath[0]] : 0.0))
+				return -1;
+			continue;
 		}
 		
-		int numNeighbors = 0;
 		int neighbor[2];			// Row and column of a neighbor
-		int tmp[CONNECTIVITY];		// Vector that will contain all the possible neighbors of "c"
+		int posN;
+		double tmpG, h;
+		bool newOpenSetCell;
 		
-		// For cell "c", each possible neighbor is checked
-		int deltaRow, deltaCol;
-		for (deltaRow=-1; deltaRow<=1; deltaRow++){
-			for (deltaCol=-1; deltaCol<=1; deltaCol++){
-				if (deltaRow != 0 || deltaCol != 0){	// This excludes the cell itself from the evaluation
-					if (check_a_neighbor(deltaRow, deltaCol, c, map)) {
-						neighbor[0] = c[0] + deltaRow;
-						neighbor[1] = c[1] + deltaCol;
-						tmp[numNeighbors] = neighbor[0]*DIM + neighbor[1];
-						numNeighbors++;
+		// Loop for checking every free neighbor of the current cell: the bits set in its walkability mask, lowest first
+		for (unsigned int mask = freeNeighbors(map, posC, c[0], c[1]); mask != 0; mask &= mask - 1) {
+			int direction = neighborDirections[__builtin_ctz(mask)];
+			neighbor[0] = c[0] + cellDeltaRow[direction];
+			neighbor[1] = c[1] + cellDeltaCol[direction];
+			posN = posC + ctx->cellOffset[direction];
+
+			// Check if the neighbor is already in the closed set. If it is, nothing is done, otherwise it is evaluated
+			if(!closedSetContains(&ctx->closedSet, posN)){
+				cellTouch(cells, posN);
+				tmpG = cells->g[posC] + cellMoveCost[direction];
+				h = heuristic(ctx, map, neighbor, goal);
+				newOpenSetCell = false;
+
+				// Check if the neighbor is already in the open set. If it is NOT, a new cell was discovered
+				if (openSetContains(&ctx->openSet, posN)) {
+
+					// Check if the neighbor has been reached with a lower cost than before. If yes, its value of "g" is updated, otherwise nothing is done
+					if (tmpG < cells->g[posN]) {
+						cells->g[posN] = tmpG;
 					}
+				} else if(!foundPath || (foundPath && tmpG + h < cells->g[ctx->bestPath[0]])){
+					cells->g[posN] = tmpG;
+					newOpenSetCell = true;
+				}
+
+				cells->parent[posN] = (direction + CELL_DIRECTIONS/2) % CELL_DIRECTIONS;	// Direction from the neighbor to "c"
+
+				// Add "neighbor" to the "openSet" or move it according to its new value of "f"
+				if (newOpenSetCell) {
+					if (!openSetPush(&ctx->openSet, posN, cells->g[posN] + h))
+						return -1;
+				} else if (openSetContains(&ctx->openSet, posN)) {
+					openSetDecreaseKey(&ctx->openSet, posN, cells->g[posN] + h);
 				}
 			}
 		}
-	
-		int neighbors[numNeighbors];
-		for (int i=0; i<numNeighbors; i++){
-			neighbors[i] = tmp[i];
+	}
+}
+
+/* Add a cell to the inconsistent cells of the anytime search, i.e., the cells reached with a lower cost after they have been
+expanded in the current round + possible reallocation of the list. It is returned false in case of failed allocation. */
+bool anytimeAddInconsistent(SearchContext *ctx, int pos){
+	if (!reserveVector(ctx, &ctx->incons, &ctx->allocIncons, ctx->numIncons + 1))
+		return false;
+	ctx->incons[ctx->numIncons++] = pos;
+	return true;
+}
+
+/* One round of the anytime search (ImprovePath of ARA*): the cells are expanded in order of g + weight*h until none of them
+can lead to a path shorter than the one known to the goal point. Unlike findPath(), the parent of a cell is changed only when the
+cell is reached with a lower cost, and a cell reached with a lower cost after its expansion is not expanded again in this round
+but it is kept among the inconsistent cells for the next one. Once a path is known, the round is interrupted at the time
+"deadline" (0: no deadline). It is returned 1 if the round is complete, 0 if it has been interrupted and -1 in case of failed
+allocation. */
+int anytimeImprovePath(SearchContext *ctx, Map *map, int goal[], double weight, double deadline){
+	CellState *cells = &ctx->cells;
+	int posGoal = calculatePos(map, goal);
+	while (ctx->openSet.size > 0 && openSetTopF(&ctx->openSet) < (cellReached(cells, posGoal) ? cells->g[posGoal] : INFINITY)) {
+		if (deadline > 0 && (ctx->closedSet.size & (ANYTIME_CHECK - 1)) == 0 && cellReached(cells, posGoal) && monotonicTime() >= deadline)
+			return 0;
+		int posC = openSetPop(&ctx->openSet);
+		int c[2] = {posC / map->cols, posC % map->cols};
+		closedSetAdd(&ctx->closedSet, posC);
+		STATS(ctx->stats.expanded++);
+
+		for (unsigned int mask = freeNeighbors(map, posC, c[0], c[1]); mask != 0; mask &= mask - 1) {
+			int direction = neighborDirections[__builtin_ctz(mask)];
+			int neighbor[2] = {c[0] + cellDeltaRow[direction], c[1] + cellDeltaCol[direction]};
+			int posN = posC + ctx->cellOffset[direction];
+			double tmpG = cells->g[posC] + cellMoveCost[direction];
+			if (tmpG >= cellG(cells, posN))
+				continue;
+
+			cellTouch(cells, posN);
+			cells->g[posN] = tmpG;
+			cells->parent[posN] = (direction + CELL_DIRECTIONS/2) % CELL_DIRECTIONS;	// Direction from the neighbor to "c"
+			if (closedSetContains(&ctx->closedSet, posN)) {
+				if (!anytimeAddInconsistent(ctx, posN))
+					return -1;
+				continue;
+			}
+			double f = tmpG + weight*heuristic(ctx, map, neighbor, goal);
+			if (openSetContains(&ctx->openSet, posN))
+				openSetDecreaseKey(&ctx->openSet, posN, f);
+			else if (!openSetPush(&ctx->openSet, posN, f))
+				return -1;
 		}
-				
-		int i, j, k, posN;
-		double tmpG;
-		bool isInClosedSet, newOpenSetCell;
-		
-		// Loop for checking every neighbor of the current cell	
-		for (i = 0; i < numNeighbors; i++) {
-			neighbor[0] = arrayCells[neighbors[i]].row;
-			neighbor[1] = arrayCells[neighbors[i]].col;
-			posN = calculatePos(neighbor);
-			isInClosedSet = false;
-			
-			// Check if the neighbor is already in the closed set. If it is, nothing is done, otherwise it is evaluated
-			#pragma omp parallel for private(j) shared(isInClosedSet)
-			for (j = 0; j < closedSetSize; j++) {
-				if(!isInClosedSet){
-					if (neighbor[0] == arrayCells[closedSet[j]].row && neighbor[1] == arrayCells[closedSet[j]].col) {
-						isInClosedSet = true;
-					}
-				}
+	}
+	return 1;
+}
+
+/* Path of the anytime search from the goal point "posGoal" back to the starting point, following the parents of the cells: it
+is left in ctx->bestPath and its length, which is not higher than the value of "g" of the goal point, in "*length". It is
+returned false in case of failed allocation. */
+bool anytimePath(SearchContext *ctx, int posGoal, double *length){
+	CellState *cells = &ctx->cells;
+	int pos = posGoal, pathSize = 0;
+	*length = 0.0;
+#if SEARCH_STATS
+	double begin = monotonicTime();
+#endif
+	while (1) {
+		if (!reserveVector(ctx, &ctx->bestPath, &ctx->allocBestPath, pathSize + 1))
+			return false;
+		ctx->bestPath[pathSize++] = pos;
+		int direction = cells->parent[pos];
+		if (direction == PARENT_START)
+			break;
+		*length += cellMoveCost[direction];
+		pos += ctx->cellOffset[direction];
+	}
+	ctx->bestPathSize = pathSize;
+	STATS(ctx->stats.reconstruction += monotonicTime() - begin);
+	return true;
+}
+
+/* Lower bound of the length of the shortest path after a complete round of the anytime search with the weight "weight": the
+lowest value of g + h among the cells left to be expanded (open or inconsistent), or the value of "g" of the goal point divided by
+the weight, whichever is higher. */
+double anytimeLowerBound(SearchContext *ctx, Map *map, int goal[], double weight){
+	CellState *cells = &ctx->cells;
+	double minF = INFINITY;
+	for (int i = 0; i < ctx->openSet.size + ctx->numIncons; i++) {
+		int pos = (i < ctx->openSet.size) ? ctx->openSet.heap[i].pos : ctx->incons[i - ctx->openSet.size];
+		int cell[2] = {pos / map->cols, pos % map->cols};
+		double f = cells->g[pos] + heuristic(ctx, map, cell, goal);
+		if (f < minF)
+			minF = f;
+	}
+	double g = cells->g[calculatePos(map, goal)];
+	double lower = (minF > g / weight) ? minF : g / weight;
+	return (lower < g) ? lower : g;
+}
+
+/* Anytime search between "start" and "goal" (ARA*), with the context "ctx" prepared by resetSearch(): a first path is found
+quickly with the heuristic weighted by anytime->weight, then the weight is lowered round after round, and every round reuses the
+values of "g" of the previous ones, expanding again only the cells whose cost has changed. After every round the path found is
+at most "bound" times longer than the shortest one; the search stops when the bound reaches anytime->epsilon or when the time
+budget anytime->budget is over (the first round is always completed, so that there is a path to return). If "verbose" is true,
+every path found is reported. The last path is left in ctx->bestPath, its length in "*length" and its bound in "*bound". It is
+returned 1 if a path has been found, 0 if the goal point is not reachable and -1 in case of failed allocation. */
+int findPathAnytime(SearchContext *ctx, Map *map, int start[], int goal[], const AnytimeOptions *anytime, bool verbose, double *length, double *bound){
+	double begin = monotonicTime();
+	double deadline = (anytime->budget > 0) ? begin + anytime->budget : 0.0;
+	double weight = anytime->weight;
+	double lower = 0.0;			// Lower bound of the length of the shortest path
+	int expanded = 0;			// Cells expanded in all the rounds
+	ctx->numIncons = 0;
+	if (!openSetPush(&ctx->openSet, calculatePos(map, start), weight*heuristic(ctx, map, start, goal)))
+		return -1;
+
+	while (1) {
+		int complete = anytimeImprovePath(ctx, map, goal, weight, deadline);
+		expanded += ctx->closedSet.size;
+		if (complete < 0)
+			return -1;
+		if (!cellReached(&ctx->cells, calculatePos(map, goal)))
+			return 0;
+		if (complete) {
+			double roundLower = anytimeLowerBound(ctx, map, goal, weight);
+			if (roundLower > lower)
+				lower = roundLower;
+		}
+		if (!anytimePath(ctx, calculatePos(map, goal), length))
+			return -1;
+		*bound = (*length > lower) ? *length / lower : 1.0;
+		if (verbose)
+			printf("Weight %.2f: path length %f, suboptimality bound %.4f (%d cells expanded, %.1f ms)%s\n", weight, *length, *bound,
+				expanded, (monotonicTime() - begin)*1000, complete ? "." : " - round interrupted by the time budget.");
+		if (!complete || *bound <= anytime->epsilon || weight <= anytime->epsilon || (deadline > 0 && monotonicTime() >= deadline))
+			return 1;
+
+		// Next round: lower weight, the inconsistent cells are moved into the open set and the keys of all the open cells are
+		// recomputed with the new weight
+		double next = (weight - ARA_WEIGHT_STEP < *bound) ? weight - ARA_WEIGHT_STEP : *bound;
+		weight = (next > anytime->epsilon) ? next : anytime->epsilon;
+		for (int i = 0; i < ctx->numIncons; i++) {
+			if (!openSetContains(&ctx->openSet, ctx->incons[i]) && !openSetPush(&ctx->openSet, ctx->incons[i], 0.0))
+				return -1;
+			STATS(ctx->stats.reopened++);
+		}
+		ctx->numIncons = 0;
+		for (int i = 0; i < ctx->openSet.size; i++) {
+			int pos = ctx->openSet.heap[i].pos;
+			int cell[2] = {pos / map->cols, pos % map->cols};
+			ctx->openSet.heap[i].f = ctx->cells.g[pos] + weight*heuristic(ctx, map, cell, goal);
+		}
+		openSetHeapify(&ctx->openSet);
+		STATS(if (ctx->closedSet.size > ctx->stats.peakClosed) ctx->stats.peakClosed = ctx->closedSet.size);
+		closedSetClear(&ctx->closedSet);
+	}
+}
+
+typedef struct {
+	SearchContext *side[2];		// Forward search (from the starting point) and backward search (from the goal point)
+	int target[2][2];			// Cell searched by each search: the goal point for the forward one, the starting point for the backward one
+	double mu;					// Length of the best path found so far
+	int meet;					// Cell in which the two searches of the best path meet (-1 if no path has been found)
+	int done;					// Set when the bidirectional search is over
+	int failed;					// Set in case of failed allocation
+} Bidirectional;
+
+/* Expansion of a cell by one of the two searches of the bidirectional search ("side" 0 for the forward search, 1 for the
+backward one). Both searches are A* searches towards the point from which the other one starts, with the cell state of the
+search data model, except that the parent of a cell is changed only when the cell is reached with a lower cost. When a search
+closes a cell already closed by the other one, a path through that cell is found; its length is the sum of the values of "g" of
+the two searches, and since it is the shortest path through the cell, the cell is not expanded again. Every search stops expanding the neighbors that can not lead to a path shorter than the best one, and the
+whole bidirectional search is over as soon as either open set is empty or its best cell can not improve the best path (an empty
+open set means that the best path is already known, or that the goal point is not reachable). It is returned false when
+this search has nothing left to expand. */
+bool bidirectionalStep(Bidirectional *bd, Map *map, int side){
+	SearchContext *own = bd->side[side];
+	SearchContext *other = bd->side[1 - side];
+	CellState *cells = &own->cells;
+	int done;
+	double mu;
+	#pragma omp atomic read
+	done = bd->done;
+	#pragma omp atomic read
+	mu = bd->mu;
+	if (done)
+		return false;
+	if (own->openSet.size == 0 || openSetTopF(&own->openSet) >= mu) {
+		#pragma omp atomic write
+		bd->done = 1;
+		return false;
+	}
+
+	int posC = openSetPop(&own->openSet);
+	int c[2] = {posC / map->cols, posC % map->cols};
+	if (closedSetAddShared(&own->closedSet, &other->closedSet, posC)) {
+		double length = cells->g[posC] + other->cells.g[posC];
+		#pragma omp critical (bidirectionalMeet)
+		{
+			if (length < bd->mu) {
+				#pragma omp atomic write
+				bd->mu = length;
+				bd->meet = posC;
 			}
+		}
+		return true;		// The best path through the cell is already known: its neighbors are not expanded
+	}
+	STATS(own->stats.expanded++);
 
-			if(!isInClosedSet){
-				tmpG = arrayCells[posC].g + distance(arrayCells[posC], arrayCells[posN]);					
-				if(c[0] == start[0] && c[1] == start[1]){ 	// Check if I am at the beginning, i.e., if the cell is the starting point
-					
-					// Possible reallocation of "openSet" vector
-					if(openSetSize >= allocOpen){
-						allocOpen += ALLOC;
-						openSet = (int*)realloc(openSet, allocOpen*sizeof(int));
-					}
-					
-					// Add "neighbor" to the "openSet"
-					openSet[openSetSize] = posN;
-					arrayCells[posN].g = tmpG;
-					openSetSize++;
-					
-				} else {		// General case, i.e., I am not at the begininng (the cell is NOT the starting point)
-
-					newOpenSetCell = false;
-					
-					// Check if the neighbor is already in the open set. If it is NOT, a new cell was discovered				
-					for (k = 0; k < openSetSize; k++) {
-						if (neighbor[0] == arrayCells[openSet[k]].row && neighbor[1] == arrayCells[openSet[k]].col) {
-
-								// If I am here, the neighbor is ALREADY in the open set
-
-								// Check if the neighbor has been reached with a lower cost than before. If yes, its value of "g" is updated, otherwise nothing is done 
-								if (tmpG < arrayCells[posN].g) {
-									arrayCells[posN].g = tmpG;
-								}
-								k = openSetSize;  // xit the "for" loop
-						} else if (k == openSetSize - 1) {
-
-							// If I am here, the neighbor is NOT in the "openSet", i.e., new cell discovered
-							newOpenSetCell = true;
-						}
-					}
+	for (unsigned int mask = freeNeighbors(map, posC, c[0], c[1]); mask != 0; mask &= mask - 1) {
+		int direction = neighborDirections[__builtin_ctz(mask)];
+		int neighbor[2] = {c[0] + cellDeltaRow[direction], c[1] + cellDeltaCol[direction]};
+		int posN = posC + own->cellOffset[direction];
+		if (closedSetContains(&own->closedSet, posN))
+			continue;
+		double tmpG = cells->g[posC] + cellMoveCost[direction];
+		double f = tmpG + heuristic(own, map, neighbor, bd->target[side]);
+		if (tmpG >= cellG(cells, posN) || f >= mu)
+			continue;
 
-					if (newOpenSetCell || openSetSize == 0){
-					
-						// Possible reallocation of "openSet" vector
-						if(openSetSize >= allocOpen){
-							allocOpen += ALLOC;
-							openSet = (int*)realloc(openSet, allocOpen*sizeof(int));
-						}
-						
-						// Add "neighbor" to the "openSet"
-						if(!foundPath || (foundPath && tmpG + distance(arrayCells[posN], arrayCells[posG]) < arrayCells[bestPath[0]].f)){
-							arrayCells[posN].g = tmpG;
-							openSet[openSetSize] = posN;
-							openSetSize++;
-						}
-					}
-				}
+		cellTouch(cells, posN);
+		cells->g[posN] = tmpG;
+		cells->parent[posN] = (direction + CELL_DIRECTIONS/2) % CELL_DIRECTIONS;	// Direction from the neighbor to "c"
+		if (openSetContains(&own->openSet, posN)) {
+			openSetDecreaseKey(&own->openSet, posN, f);
+		} else if (!openSetPush(&own->openSet, posN, f)) {
+			#pragma omp atomic write
+			bd->failed = 1;
+			#pragma omp atomic write
+			bd->done = 1;
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Number of cells from "pos" to the starting point of a search, following the parents. */
+int bidirectionalChainSize(CellState *cells, Map *map, int pos){
+	int size = 1;
+	while (cells->parent[pos] != PARENT_START) {
+		pos += cellDeltaRow[cells->parent[pos]]*map->cols + cellDeltaCol[cells->parent[pos]];
+		size++;
+	}
+	return size;
+}
+
+/* Run the two searches of the bidirectional search one step each in turn, until both are over. */
+void bidirectionalAlternate(Bidirectional *bd, Map *map){
+	bool active[2] = {true, true};
+	for (int side = 0; (active[0] || active[1]) && !bd->done; side = 1 - side) {
+		if (active[side])
+			active[side] = bidirectionalStep(bd, map, side);
+	}
+}
+
+/* Bidirectional search between "start" and "goal": a forward search from the starting point (context ctx[0], prepared by
+resetSearch() from "start" to "goal") and a backward search from the goal point (context ctx[1], prepared from "goal" to
+"start") on two threads at the same time (one step each in turn if only
+one thread is available, e.g., inside the batch mode). The best path is spliced in the meeting cell and left in ctx[0].bestPath, its length in "*length".
+It is returned 1 if a path has been found, 0 if the goal point is not reachable and -1 in case of failed allocation. */
+int findPathBidirectional(SearchContext ctx[], Map *map, int start[], int goal[], double *length){
+	Bidirectional bd = {{&ctx[0], &ctx[1]}, {{goal[0], goal[1]}, {start[0], start[1]}}, INFINITY, -1, 0, 0};
+	openSetPush(&ctx[0].openSet, calculatePos(map, start), distance(start, goal));
+	openSetPush(&ctx[1].openSet, calculatePos(map, goal), distance(start, goal));
+
+	#pragma omp parallel num_threads(2)
+	{
+		if (omp_get_num_threads() == 2) {
+			int side = omp_get_thread_num();
+			while (bidirectionalStep(&bd, map, side));
+		} else {
+			bidirectionalAlternate(&bd, map);
+		}
+	}
+	if (bd.failed)
+		return -1;
+	if (bd.meet < 0)
+		return 0;
+
+	// The path from the goal point to the meeting cell (backward search), then from the meeting cell to the starting point
+#if SEARCH_STATS
+	double begin = monotonicTime();
+#endif
+	CellState *forward = &ctx[0].cells, *backward = &ctx[1].cells;
+	int forwardSize = bidirectionalChainSize(forward, map, bd.meet);
+	int backwardSize = bidirectionalChainSize(backward, map, bd.meet);
+	int pathSize = forwardSize + backwardSize - 1;
+	if (!reserveVector(&ctx[0], &ctx[0].bestPath, &ctx[0].allocBestPath, pathSize))
+		return -1;
+	int pos = bd.meet;
+	for (int i = backwardSize-1; i >= 0; i--) {
+		ctx[0].bestPath[i] = pos;
+		if (i > 0)
+			pos += cellDeltaRow[backward->parent[pos]]*map->cols + cellDeltaCol[backward->parent[pos]];
+	}
+	pos = bd.meet;
+	for (int i = backwardSize; i < pathSize; i++) {
+		pos += cellDeltaRow[forward->parent[pos]]*map->cols + cellDeltaCol[forward->parent[pos]];
+		ctx[0].bestPath[i] = pos;
+	}
+	ctx[0].bestPathSize = pathSize;
+	*length = bd.mu;
+	STATS(ctx[0].stats.reconstruction += monotonicTime() - begin);
+	return 1;
+}
+
+typedef struct {
+	MultiQueue queue;			// Cells to be expanded, shared by all the threads
+	const SearchContext *ctx;	// Context of the search - only its heuristic is used by the threads
+	double *g;					// Distance (cost) between a cell and the starting point, updated with atomic operations
+	int posGoal;				// Position of the goal point
+	int goal[2];				// Row and column of the goal point
+	long long pending;			// Cells in the queue + cells being expanded - the search is over when there are none
+	long long expanded;			// Number of cells expanded (a cell can be expanded more than once)
+	long long stale;			// Number of cells removed from the queue and discarded because their value of "g" was old
+	int failed;					// Set to 1 in case of failed allocation
+} MultiQueueSearch;
+
+/* Lower the value of "g" of the cell "pos" to "newG" with an atomic compare-and-swap. It is returned true if the value has been
+lowered, false if the cell already had a value not higher than "newG". */
+static inline bool lowerG(double *g, int pos, double newG){
+	double oldG;
+	#pragma omp atomic compare capture
+	{ oldG = g[pos]; if (newG < g[pos]) { g[pos] = newG; } }
+	return newG < oldG;
+}
+
+/* Expansion of a cell removed from the queue by a thread ("seed" is the state of its random number generator): every neighbor
+reached with a lower cost is added to the queue, unless it can not improve the best path found (of length "mu"). */
+void multiQueueExpand(MultiQueueSearch *mqs, Map *map, uint32_t *seed, MultiQueueNode node, double mu){
+	int c[2] = {node.pos / map->cols, node.pos % map->cols};
+	for (unsigned int mask = freeNeighbors(map, node.pos, c[0], c[1]); mask != 0; mask &= mask - 1) {
+		int direction = neighborDirections[__builtin_ctz(mask)];
+		int neighbor[2] = {c[0] + cellDeltaRow[direction], c[1] + cellDeltaCol[direction]};
+		int posN = node.pos + mqs->ctx->cellOffset[direction];
+		double tmpG = node.g + cellMoveCost[direction];
+		double h = heuristic(mqs->ctx, map, neighbor, mqs->goal);
+		if (tmpG + h >= mu || !lowerG(mqs->g, posN, tmpG))
+			continue;
+		if (posN == mqs->posGoal)
+			continue;		// The goal point is never expanded: its value of "g" is the length of the best path found
+		#pragma omp atomic update
+		mqs->pending += 1;
+		if (!multiQueuePush(&mqs->queue, seed, tmpG + h, tmpG, posN)) {
+			#pragma omp atomic write
+			mqs->failed = 1;
+		}
+	}
+}
+
+/* Work of a thread of the search: cells are removed from the queue and expanded until the queue is empty and no other thread is
+expanding a cell. A cell removed from the queue with a value of "g" higher than the current one has been reached again with a
+lower cost after it has been added, so it is discarded (the other copy in the queue will be expanded); a cell reached with a
+lower cost after its expansion is expanded again, so the value of "g" of every cell is the optimal one when the search ends. */
+void multiQueueWorker(MultiQueueSearch *mqs, Map *map, uint32_t seed){
+	long long expanded = 0, stale = 0;
+	while (1) {
+		int failed;
+		#pragma omp atomic read
+		failed = mqs->failed;
+		if (failed)
+			break;
+		MultiQueueNode node;
+		if (!multiQueuePop(&mqs->queue, &seed, &node)) {
+			long long pending;
+			#pragma omp atomic read
+			pending = mqs->pending;
+			if (pending == 0)
+				break;
+			sched_yield();		// Other threads are expanding cells that can add new ones to the queue
+			continue;
+		}
+		double g, mu;
+		#pragma omp atomic read
+		g = mqs->g[node.pos];
+		#pragma omp atomic read
+		mu = mqs->g[mqs->posGoal];
+		if (node.g > g || node.f >= mu) {
+			stale++;
+		} else {
+			multiQueueExpand(mqs, map, &seed, node, mu);
+			expanded++;
+		}
+		#pragma omp atomic update
+		mqs->pending -= 1;
+	}
+	#pragma omp atomic update
+	mqs->expanded += expanded;
+	#pragma omp atomic update
+	mqs->stale += stale;
+}
+
+/* Parallel search between "start" and "goal" in which all the threads take the cells to be expanded from the same relaxed
+priority queue (see "multi-queue.h") and lower the values of "g" of the cells with atomic operations. The values of "g" are kept
+in ctx->cells.g (the stamps are not used) and the best path is left in ctx->bestPath, its length in "*length". The path is
+rebuilt from the goal point choosing every time the neighbor "n" with the lowest g(n) + distance(n, cell), so no parent has to
+be kept consistent with "g" by the threads. It is returned 1 if a path has been found, 0 if the goal point is not reachable and
+-1 in case of failed allocation. The number of cells expanded and of the ones discarded is returned in "expanded" and "stale". */
+int findPathMultiQueue(SearchContext *ctx, Map *map, int start[], int goal[], double *length, long long *expanded, long long *stale){
+	int numCells = map->rows*map->cols;
+	MultiQueueSearch mqs = {{NULL, 0}, ctx, ctx->cells.g, calculatePos(map, goal), {goal[0], goal[1]}, 1, 0, 0, 0};
+	if (!multiQueueInit(&mqs.queue, omp_get_max_threads(), ALLOC))
+		return -1;
+
+	#pragma omp parallel for
+	for (int i = 0; i < numCells; i++)
+		mqs.g[i] = INFINITY;
+	int posS = calculatePos(map, start);
+	mqs.g[posS] = 0.0;
+	uint32_t seed = 1;
+	if (!multiQueuePush(&mqs.queue, &seed, distance(start, goal), 0.0, posS)) {
+		multiQueueFree(&mqs.queue);
+		return -1;
+	}
+
+	#pragma omp parallel
+	multiQueueWorker(&mqs, map, 2654435761u*(omp_get_thread_num() + 1));
+	multiQueueFree(&mqs.queue);
+	*expanded = mqs.expanded;
+	*stale = mqs.stale;
+	if (mqs.failed)
+		return -1;
+	if (mqs.g[mqs.posGoal] == INFINITY)
+		return 0;
 
-				arrayCells[posN].h = distance(arrayCells[posN], arrayCells[posG]);
-				arrayCells[posN].f = arrayCells[posN].g + arrayCells[posN].h;
-				arrayCells[posN].parentRow = c[0];
-				arrayCells[posN].parentCol = c[1];			
+	// Path from the goal point to the starting point
+	int pos = mqs.posGoal, pathSize = 0;
+	while (1) {
+		if (!reserveVector(ctx, &ctx->bestPath, &ctx->allocBestPath, pathSize + 1))
+			return -1;
+		ctx->bestPath[pathSize++] = pos;
+		if (pos == posS)
+			break;
+		int c[2] = {pos / map->cols, pos % map->cols};
+		int best = -1;
+		double bestG = INFINITY;
+		for (unsigned int mask = freeNeighbors(map, pos, c[0], c[1]); mask != 0; mask &= mask - 1) {
+			int direction = neighborDirections[__builtin_ctz(mask)];
+			int posN = pos + ctx->cellOffset[direction];
+			if (mqs.g[posN] + cellMoveCost[direction] < bestG) {
+				bestG = mqs.g[posN] + cellMoveCost[direction];
+				best = posN;
 			}
 		}
+		pos = best;
 	}
+	ctx->bestPathSize = pathSize;
+	*length = mqs.g[mqs.posGoal];
+	return 1;
 }
 
-int main () {	
+/* Search of the best path between "start" and "goal" with the engine "engine", the landmarks "landmarks" (NULL if they are
+not used) and the options "anytime" of the anytime search, and printing of the result. The time of the preparation of the
+search, of the search itself and of the output is added to "times". */
+void search (Map *map, int start[], int goal[], Engine engine, Hierarchy *hierarchy, const Landmarks *landmarks, const AnytimeOptions *anytime, PhaseTimes *times, const PathOutput *output) {	
+	if (engine == ENGINE_HPA) {
+		if (searchHierarchy(map, hierarchy, start, goal, times, output))
+			return;
+		printf("Searching with A*...\n");
+		engine = ENGINE_ASTAR;
+	}
+
+	double begin = monotonicTime();
+	printf("Filling the cells... ");
+	SearchContext ctx[2];		// The second context is used only by the backward search of the bidirectional search
+	int numContexts = (engine == ENGINE_BIDIR) ? 2 : 1;
+	if (!searchContextsInit(ctx, numContexts, map, engine, landmarks)) {
+		printf("\nFailed allocation.\n");
+		return;
+	}
+
+	// Initialization of each cell
+	resetSearch(&ctx[0], map, start, goal);
+	if (engine == ENGINE_BIDIR)
+		resetSearch(&ctx[1], map, goal, start);
+	printf("InitCells completed.\n");
+
+	JumpTable jumps = {NULL};	// Jump distances of every cell - only for Jump Point Search
+	if (engine == ENGINE_JPS) {
+		printf("Computing the jump distances... ");
+		if (!jumpTableBuild(&jumps, map)) {
+			printf("\nFailed allocation.\n");
+			searchContextsFree(ctx, numContexts);
+			return;
+		}
+		printf("Jump distances computed.\n");
+	}
+	times->init += monotonicTime() - begin;
+
+	printf("Searching the best path...\n");
+	begin = monotonicTime();
+	double length = 0.0;
+	int found;
+	if (engine == ENGINE_BIDIR) {
+		found = findPathBidirectional(ctx, map, start, goal, &length);
+		printf("%d cells expanded (%d forward, %d backward).\n", ctx[0].closedSet.size + ctx[1].closedSet.size, ctx[0].closedSet.size, ctx[1].closedSet.size);
+	} else if (engine == ENGINE_MQ) {
+		long long expanded, stale;
+		found = findPathMultiQueue(&ctx[0], map, start, goal, &length, &expanded, &stale);
+		STATS(ctx[0].stats.expanded = expanded);
+		printf("%lld cells expanded by %d threads (%lld old cells discarded).\n", expanded, omp_get_max_threads(), stale);
+	} else if (engine == ENGINE_ARA) {
+		double bound;
+		found = findPathAnytime(&ctx[0], map, start, goal, anytime, true, &length, &bound);
+		if (found == 1)
+			printf("The path found is at most %.4f times longer than the shortest one.\n", bound);
+	} else {
+		found = findPath(&ctx[0], map, start, goal, engine, &jumps);
+		if (found == 1)
+			length = ctx[0].cells.g[ctx[0].bestPath[0]];
+		printf("%d cells expanded.\n", ctx[0].closedSet.size);
+	}
+	times->search += monotonicTime() - begin;
+	begin = monotonicTime();
+	if (found < 0)
+		printf("\nFailed allocation.\n");
+	else
+		endSearch(found == 1, length, ctx[0].bestPath, ctx[0].bestPathSize, map, calculatePos(map, start), calculatePos(map, goal), output);
+	times->output += monotonicTime() - begin;
+	STATS(searchStatsReport(ctx, numContexts, NULL, engine, start, goal, found, length, times));
+	jumpTableFree(&jumps);
+	searchContextsFree(ctx, numContexts);
+}
+
+/* Read the next batch of changes from the edit file "fp": one "<row> <col> <state>" line per cell (state 1 = free, 0 =
+occupied), the batches separated by empty lines. The changes are returned in "*edits" (row, column and state of each one),
+which has room for "*alloc" changes and is reallocated if needed. It is returned the number of changes of the batch, 0 at the end
+of the file and -1 in case of error (an error message is shown). */
+int readEditBatch(FILE *fp, Map *map, int **edits, int *alloc){
+	char line[256];
+	int numEdits = 0;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		int e[3];
+		char extra;
+		if (sscanf(line, " %c", &extra) != 1) {
+			if (numEdits > 0)
+				break;		// End of the batch
+			continue;
+		}
+		if (sscanf(line, "%d %d %d %c", &e[0], &e[1], &e[2], &extra) != 3 || !check_position(map, e) || (e[2] != 0 && e[2] != 1)) {
+			printf("Error: \"%.*s\" is not a valid change of a cell.\n", (int)strcspn(line, "\r\n"), line);
+			return -1;
+		}
+		if (numEdits >= *alloc) {
+			int *grown = (int *)realloc(*edits, 2*(*alloc)*3*sizeof(int));
+			if (grown == NULL) {
+				printf("\nFailed allocation.\n");
+				return -1;
+			}
+			*edits = grown;
+			*alloc *= 2;
+		}
+		memcpy(*edits + 3*numEdits++, e, sizeof(e));
+	}
+	return numEdits;
+}
+
+/* Batch of "numEdits" random changes for the replanning benchmark: every change turns a cell from free to occupied or the other
+way round, and half of the cells, on average, are taken from the current path "path" (of "pathSize" cells), so that the path has
+to be repaired. The starting point and the goal point are never changed. */
+void randomEdits(Map *map, int path[], int pathSize, int numEdits, int edits[]){
+	int numCells = map->rows*map->cols;
+	for (int i = 0; i < numEdits; i++) {
+		int pos = (rand() % 2 == 0 && pathSize > 2) ? path[1 + rand() % (pathSize - 2)] : rand() % numCells;
+		if (pos == path[0] || pos == path[pathSize-1]) {
+			i--;
+			continue;
+		}
+		edits[3*i] = pos / map->cols;
+		edits[3*i+1] = pos % map->cols;
+		edits[3*i+2] = !mapIsFree(map, pos / map->cols, pos % map->cols);
+	}
+}
+
+/* Rounds of the incremental replanning (see replan()), with the search context "ctx" and the state of D* Lite "ds" already
+allocated. It is returned false in case of error. */
+bool replanRounds(SearchContext *ctx, DStarLite *ds, Map *map, int start[], int goal[], FILE *fp, int randomChanges, const PathOutput *output){
+	int posS = calculatePos(map, start), posG = calculatePos(map, goal);
+	int allocEdits = (randomChanges > ALLOC) ? randomChanges : ALLOC;
+	int allocPath = ALLOC;
+	int *edits = (int *)malloc(3*allocEdits*sizeof(int));
+	int *changed = (int *)malloc(allocEdits*sizeof(int));		// Positions of the cells actually changed by a batch
+	int *path = (int *)malloc(allocPath*sizeof(int));
+	double length = 0.0;
+	int pathSize = -1;
+	struct timespec begin, end;
+	if (edits != NULL && changed != NULL && path != NULL) {
+		clock_gettime(CLOCK_MONOTONIC, &begin);
+		pathSize = dStarLitePlan(ds, map, posS, posG) ? dStarLitePath(ds, map, &path, &allocPath, &length) : -1;
+		clock_gettime(CLOCK_MONOTONIC, &end);
+	}
+	if (pathSize < 0) {
+		printf("\nFailed allocation.\n");
+		free(edits);
+		free(changed);
+		free(path);
+		return false;
+	}
+	printf("First search: %f ms (%lld cells expanded), ", ((end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9)*1000, ds->expanded);
+	if (pathSize > 0)
+		printf("path length %f.\n", length);
+	else
+		printf("goal not reachable.\n");
+
+	double totalRepair = 0.0, totalScratch = 0.0;
+	int rounds = 0;
+	bool ok = true;
+	srand(REPLAN_SEED);
+	while (ok && (fp != NULL || rounds < REPLAN_ROUNDS)) {
+		int numEdits = randomChanges;
+		if (fp != NULL) {
+			numEdits = readEditBatch(fp, map, &edits, &allocEdits);
+			if (numEdits <= 0) {
+				ok = numEdits == 0;
+				break;
+			}
+			int *grown = (int *)realloc(changed, allocEdits*sizeof(int));
+			if (grown == NULL) {
+				printf("\nFailed allocation.\n");
+				ok = false;
+				break;
+			}
+			changed = grown;
+		} else {
+			int endpoints[2] = {posG, posS};		// The path is empty when the goal point is not reachable
+			randomEdits(map, (pathSize > 0) ? path : endpoints, (pathSize > 0) ? pathSize : 2, numEdits, edits);
+		}
+
+		// The changes are applied to the map (the starting point and the goal point are always free)
+		int numChanged = 0;
+		for (int i = 0; i < numEdits; i++) {
+			int *e = edits + 3*i;
+			int pos = calculatePos(map, e);
+			if (pos != posS && pos != posG && mapIsFree(map, e[0], e[1]) != (e[2] == 1)) {
+				mapSetCell(map, e[0], e[1], e[2] == 1);
+				changed[numChanged++] = pos;
+			}
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &begin);
+		pathSize = dStarLiteUpdate(ds, map, changed, numChanged) ? dStarLitePath(ds, map, &path, &allocPath, &length) : -1;
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double repair = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+
+		clock_gettime(CLOCK_MONOTONIC, &begin);
+		resetSearch(ctx, map, start, goal);
+		int found = findPath(ctx, map, start, goal, ENGINE_ASTAR, NULL);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		double scratch = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+		if (pathSize < 0 || found < 0) {
+			printf("\nFailed allocation.\n");
+			ok = false;
+			break;
+		}
+
+		rounds++;
+		totalRepair += repair;
+		totalScratch += scratch;
+		printf("Round %d: %d cells changed - D* Lite %f ms (%lld cells expanded), A* from scratch %f ms (%d cells expanded), ", rounds,
+			numChanged, repair*1000, ds->expanded, scratch*1000, ctx->closedSet.size);
+		if (pathSize > 0)
+			printf("path length %f", length);
+		else
+			printf("goal not reachable");
+		if ((pathSize > 0) != (found == 1) || (found == 1 && fabs(length - ctx->cells.g[ctx->bestPath[0]]) > 1e-6))
+			printf(" - A* found a different result!");
+		printf(".\n");
+	}
+
+	if (rounds > 0)
+		printf("\nAverage over %d rounds: D* Lite %f ms, A* from scratch %f ms (%.1f times faster).\n", rounds, totalRepair*1000 / rounds,
+			totalScratch*1000 / rounds, totalScratch / totalRepair);
+	if (ok && pathSize > 0)
+		printPath(length, path, pathSize, map, output);
+	else if (ok)
+		printf("\nGoal not reachable!\n");
+	free(edits);
+	free(changed);
+	free(path);
+	return ok;
+}
+
+/* Incremental replanning between "start" and "goal" (see "d-star-lite.h"): after a first search, the map is changed by the
+batches of changes of the edit file "editFile" or, if it is NULL, by REPLAN_ROUNDS batches of "randomChanges" random changes
+(see randomEdits()). After every batch the path is repaired by D* Lite and, for comparison, searched again from scratch by A*,
+and the times of both are printed. The last path is printed in the output file. */
+void replan(Map *map, int start[], int goal[], const char *editFile, int randomChanges, const PathOutput *output){
+	FILE *fp = NULL;
+	if (editFile != NULL && (fp = fopen(editFile, "r")) == NULL) {
+		printf("Error while opening the edit file %s.\n", editFile);
+		return;
+	}
+	SearchContext ctx;
+	DStarLite ds;
+	bool ctxOk = searchContextInit(&ctx, map, ENGINE_ASTAR, NULL);
+	bool dsOk = dStarLiteInit(&ds, map, NEIGHBOR_MASK);
+	if (ctxOk && dsOk)
+		replanRounds(&ctx, &ds, map, start, goal, fp, randomChanges, output);
+	else
+		printf("\nFailed allocation.\n");
+	if (ctxOk)
+		searchContextFree(&ctx);
+	if (dsOk)
+		dStarLiteFree(&ds);
+	if (fp != NULL)
+		fclose(fp);
+}
+
+/* Answer a query of the batch mode with the search contexts "ctx" (two for the bidirectional search, NULL if they could not be
+allocated) and the arena "arena" for the scratch memory of the hierarchical search (NULL if it could not be allocated). The
+path found is copied in the result, so that the contexts and the arena can be used for the next query. */
+void answerQuery(BatchResult *result, SearchContext ctx[], Arena *arena, Map *map, Engine engine, JumpTable *jumps, Hierarchy *hierarchy, const AnytimeOptions *anytime){
+	int start[2] = {result->query[0], result->query[1]};
+	int goal[2] = {result->query[2], result->query[3]};
+	result->path = NULL;
+	result->bound = 0.0;
+
+	// The map is shared by all the queries, so the starting point and the goal point are not made free
+	if (!(check_position(map, start) && check_position(map, goal)) || !(is_free(start, map) && is_free(goal, map)) || is_goal(start, goal)) {
+		result->status = -2;
+		return;
+	}
+
+#if SEARCH_STATS
+	PhaseTimes times = {0.0, 0.0, 0.0, 0.0};		// Only the preparation and the search are timed for every query
+	double begin = monotonicTime();
+#endif
+	if (engine == ENGINE_HPA) {
+		result->status = (arena != NULL) ? hierarchySearch(hierarchy, map, arena, calculatePos(map, start), calculatePos(map, goal), &result->path, &result->pathSize, &result->length) : -1;
+		if (result->status != 0) {
+			STATS(times.search = monotonicTime() - begin; searchStatsReport(NULL, 0, NULL, ENGINE_HPA, start, goal, result->status, result->length, &times));
+			return;
+		}
+		engine = ENGINE_ASTAR;		// The abstract graph does not connect the two points: the plain A* search decides
+	}
+
+	if (ctx == NULL) {
+		result->status = -1;
+		return;
+	}
+	STATS(begin = monotonicTime());
+	resetSearch(ctx, map, start, goal);
+	if (engine == ENGINE_BIDIR)
+		resetSearch(&ctx[1], map, goal, start);
+	STATS(times.init = monotonicTime() - begin; begin = monotonicTime());
+	if (engine == ENGINE_BIDIR) {
+		result->status = findPathBidirectional(ctx, map, start, goal, &result->length);
+	} else if (engine == ENGINE_ARA) {
+		result->status = findPathAnytime(ctx, map, start, goal, anytime, false, &result->length, &result->bound);
+	} else {
+		result->status = findPath(ctx, map, start, goal, engine, jumps);
+		if (result->status == 1)
+			result->length = ctx->cells.g[ctx->bestPath[0]];
+	}
+	STATS(times.search = monotonicTime() - begin);
+	STATS(searchStatsReport(ctx, (engine == ENGINE_BIDIR) ? 2 : 1, NULL, engine, start, goal, result->status, result->length, &times));
+	if (result->status == 1) {
+		result->pathSize = ctx->bestPathSize;
+		result->path = (int *)malloc(ctx->bestPathSize*sizeof(int));
+		if (result->path == NULL)
+			result->status = -1;
+		else
+			memcpy(result->path, ctx->bestPath, ctx->bestPathSize*sizeof(int));
+	}
+}
+
+/* Write the results of the batch mode in the file "fname", one line per query, in the same order of the queries:
+	<start row> <start col> <goal row> <goal col> <length> <moves>		path found, moves as in the "runs" output format
+	<start row> <start col> <goal row> <goal col> <length> <bound> <moves>	path found by the anytime search, with its bound
+	<start row> <start col> <goal row> <goal col> unreachable			goal point not reachable
+	<start row> <start col> <goal row> <goal col> invalid				point out of the map or not free, or coincident points
+	<start row> <start col> <goal row> <goal col> error					failed allocation
+It is returned false in case of error. */
+bool writeBatchResults(BatchResult results[], int numQueries, Map *map, const char *fname){
+	static const char *outcomes[] = {"invalid", "error", "unreachable"};
+	FILE *fp = fopen(fname, "w");
+	if (fp == NULL)
+		return false;
+	bool ok = true;
+	for (int i = 0; ok && i < numQueries; i++) {
+		int *q = results[i].query;
+		ok = fprintf(fp, "%d %d %d %d ", q[0], q[1], q[2], q[3]) >= 0;
+		if (ok && results[i].status == 1)
+			ok = fprintf(fp, "%f ", results[i].length) >= 0 && (results[i].bound == 0.0 || fprintf(fp, "%f ", results[i].bound) >= 0)
+				&& writeMoves(fp, map->cols, results[i].path, results[i].pathSize);
+		else if (ok)
+			ok = fprintf(fp, "%s", outcomes[results[i].status + 2]) >= 0;
+		ok = ok && fprintf(fp, "\n") >= 0;
+	}
+	return (fclose(fp) == 0) && ok;
+}
+
+/* Read the queries of the batch mode from the file "fname", one "<start row> <start col> <goal row> <goal col>" per line. The
+queries are returned in a vector of results (allocated with malloc) and their number in "*numQueries". In case of an error an
+error message is shown and NULL is returned. */
+BatchResult *readQueries(const char *fname, int *numQueries){
+	FILE *fp = fopen(fname, "r");
+	if (fp == NULL) {
+		printf("Error while opening the query file %s.\n", fname);
+		return NULL;
+	}
+	int allocQueries = ALLOC;
+	BatchResult *results = (BatchResult *)malloc(allocQueries*sizeof(BatchResult));
+	int q[4];
+	*numQueries = 0;
+	while (results != NULL && fscanf(fp, "%d %d %d %d", &q[0], &q[1], &q[2], &q[3]) == 4) {
+		if (*numQueries >= allocQueries) {
+			allocQueries *= 2;
+			BatchResult *grown = (BatchResult *)realloc(results, allocQueries*sizeof(BatchResult));
+			if (grown == NULL)
+				free(results);
+			results = grown;
+			if (results == NULL)
+				break;
+		}
+		memcpy(results[*numQueries].query, q, sizeof(q));
+		results[*numQueries].path = NULL;
+		(*numQueries)++;
+	}
+	if (results == NULL) {
+		printf("\nFailed allocation.\n");
+	} else if (!feof(fp)) {
+		printf("Error: line %d of %s is not a valid query.\n", *numQueries + 1, fname);
+		free(results);
+		results = NULL;
+	}
+	fclose(fp);
+	return results;
+}
+
+/* Batch mode: the queries of the file "queryFile" are answered on the same map, which is loaded only once and is only read by
+the searches (the jump distances and the abstraction of the map are shared too). The queries are distributed among the
+threads, each of them with its own search context, reused for all its queries. The results are written in the file "resultFile" in
+the same order of the queries (see writeBatchResults()). It is returned false in case of error. */
+bool runBatch(Map *map, const char *queryFile, Engine engine, Hierarchy *hierarchy, const Landmarks *landmarks, const AnytimeOptions *anytime, const char *resultFile){
+	int numQueries;
+	BatchResult *results = readQueries(queryFile, &numQueries);
+	if (results == NULL)
+		return false;
+	printf("%d queries read from %s.\n", numQueries, queryFile);
+
+	JumpTable jumps = {NULL};
+	if (engine == ENGINE_JPS) {
+		printf("Computing the jump distances... ");
+		if (!jumpTableBuild(&jumps, map)) {
+			printf("\nFailed allocation.\n");
+			free(results);
+			return false;
+		}
+		printf("Jump distances computed.\n");
+	}
+
+	printf("Answering the queries...\n");
+	struct timespec begin, end;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	#pragma omp parallel
+	{
+		SearchContext ctx[2];		// The second context is used only by the backward search of the bidirectional search
+		int numContexts = (engine == ENGINE_BIDIR) ? 2 : 1;
+		bool ready = searchContextsInit(ctx, numContexts, map, engine, landmarks);
+		Arena arena = {NULL, 0, 0};		// Scratch memory of the hierarchical search, reused by all the queries
+		bool arenaReady = (engine == ENGINE_HPA) && arenaInit(&arena, hierarchySearchBytes(hierarchy));
+		#pragma omp for schedule(dynamic)
+		for (int i = 0; i < numQueries; i++)
+			answerQuery(&results[i], ready ? ctx : NULL, arenaReady ? &arena : NULL, map, engine, &jumps, hierarchy, anytime);
+		if (ready)
+			searchContextsFree(ctx, numContexts);
+		arenaFree(&arena);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+	printf("%d queries answered in %f s (%.1f queries/s with %d threads).\n", numQueries, seconds, numQueries / seconds, omp_get_max_threads());
+
+	bool ok = writeBatchResults(results, numQueries, map, resultFile);
+	if (ok)
+		printf("Results written in the file %s.\n", resultFile);
+	else
+		printf("Error while writing the output file %s.\n", resultFile);
+	for (int i = 0; i < numQueries; i++)
+		free(results[i].path);
+	free(results);
+	jumpTableFree(&jumps);
+	return ok;
+}
+
+/* Print how the program has to be launched. */
+void usage(const char *program){
+	printf("Usage: %s [-e astar|jps|hpa|bidir|mq|ara] [-w <weight>] [-s <bound>] [-t <ms>] [-l <landmarks>] [-m] [-o grid|coords|runs|pgm] <map file> [<start row> <start col> <goal row> <goal col>]\n", program);
+	printf("       %s [-r <edit file> | -k <changes>] [-m] [-o grid|coords|runs|pgm] <map file> [<start row> <start col> <goal row> <goal col>]\n", program);
+	printf("       %s [-e astar|jps|hpa|bidir|ara] [-w <weight>] [-s <bound>] [-t <ms>] [-l <landmarks>] [-m] -b <query file> <map file>\n", program);
+	printf("The dimensions of the map are obtained from the map file. By default the starting point is the top right corner\n");
+	printf("of the map and the goal point is the bottom left one. The option -e selects the search engine (default: astar,\n");
+	printf("jps is Jump Point Search, hpa the hierarchical search, whose abstraction of the map is saved in <map file>.hpa,\n");
+	printf("bidir the bidirectional search, whose forward and backward searches run on two threads in the parallel version,\n");
+	printf("mq the search whose threads share a relaxed priority queue - not available with -b,\n");
+	printf("ara the anytime search, which finds a first path with the heuristic weighted by -w and lowers the weight until\n");
+	printf("the path is at most -s times longer than the shortest one (default: 1) or -t milliseconds have passed)\n");
+	printf("and the option -o the format of the output file (default: grid, i.e., the whole map with the path).\n");
+	printf("With -l the heuristic uses the distances from that many landmarks (at most %d), saved in <map file>.alt.\n", LANDMARK_MAX);
+	printf("With -m the free neighbors of every cell are precomputed in a table of masks (one byte per cell).\n");
+	printf("With -b the queries of the query file (one \"<start row> <start col> <goal row> <goal col>\" per line) are answered\n");
+	printf("on the same map and the results are written in ./paths/batch-<map name>, one line per query.\n");
+	printf("With -r the map is changed by the batches of the edit file (one \"<row> <col> <0|1>\" line per cell, 1 = free, the\n");
+	printf("batches separated by empty lines) and after each one the path is repaired with D* Lite and searched again with A*;\n");
+	printf("with -k the same is done for %d batches of that many random changes.\n", REPLAN_ROUNDS);
+}
+
+int main (int argc, char *argv[]) {
 	if (!checkDefine()){
 		return 0;
 	}
-	
-	bool *map;
-	map = (bool *)malloc(DIM*DIM*sizeof(bool));
-	if(map == NULL) {
+
+	Engine engine = ENGINE_ASTAR;
+	const char *queryFile = NULL;		// Query file of the batch mode
+	int numLandmarks = 0;				// Number of landmarks of the heuristic (0: only the Euclidean distance)
+	bool maskTable = false;				// Whether the table of the walkability masks is built (option -m)
+	AnytimeOptions anytime = {ARA_WEIGHT, 1.0, 0.0};	// Options of the anytime search (-w, -s and -t)
+	bool anytimeSet = false;			// Whether any of them has been given
+	const char *editFile = NULL;		// Edit file of the incremental replanning (option -r)
+	int randomChanges = 0;				// Random changes per batch of the replanning benchmark (option -k)
+	PathOutput output;
+	output.format = OUTPUT_GRID;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "b:e:k:l:mo:r:s:t:w:")) != -1) {
+		bool valid = false;
+		if (opt == 'b')
+			valid = (queryFile = optarg) != NULL;
+		else if (opt == 'e')
+			valid = parseEngine(optarg, &engine);
+		else if (opt == 'k')
+			valid = (randomChanges = atoi(optarg)) > 0;
+		else if (opt == 'l')
+			valid = (numLandmarks = atoi(optarg)) > 0 && numLandmarks <= LANDMARK_MAX;
+		else if (opt == 'm')
+			valid = maskTable = true;
+		else if (opt == 'o')
+			valid = parseOutputFormat(optarg, &output.format);
+		else if (opt == 'r')
+			valid = (editFile = optarg) != NULL;
+		else if (opt == 's')
+			valid = anytimeSet = (anytime.epsilon = atof(optarg)) >= 1.0;
+		else if (opt == 't')
+			valid = anytimeSet = (anytime.budget = atof(optarg) / 1000) > 0.0;
+		else if (opt == 'w')
+			valid = anytimeSet = (anytime.weight = atof(optarg)) >= 1.0;
+		if (!valid) {
+			usage(argv[0]);
+			return 0;
+		}
+	}
+
+	int args = argc - optind;		// Number of arguments after the options
+	if ((args != 1 && args != 5) || (queryFile != NULL && (args != 1 || engine == ENGINE_MQ)) || (anytimeSet && engine != ENGINE_ARA)
+			|| ((editFile != NULL || randomChanges > 0) && (queryFile != NULL || engine != ENGINE_ASTAR || numLandmarks > 0 || (editFile != NULL && randomChanges > 0)))) {
+		usage(argv[0]);
+		return 0;
+	}
+
+	if (CONNECTIVITY != 8 && (engine == ENGINE_JPS || engine == ENGINE_HPA)) {
+		printf("The engine %s needs 8-connectivity.\n", engineNames[engine]);
+		return 0;
+	}
+
+	PhaseTimes times = {0.0, 0.0, 0.0, 0.0};
+	double begin = monotonicTime();
+	Map map;
+	if (!fillMap(&map, argv[optind])) {
+		return 0;
+	}
+	if (!mapFitsInt(&map)) {
+		freeMap(&map);
+		return 0;
+	}
+
+	// The free neighbors of the cells are read from the table of the walkability masks, if requested, otherwise they are
+	// obtained from the walkability grid during the searches
+	double maskBegin = monotonicTime();
+	if (!(maskTable ? mapMaskInit(&map) : mapBorderInit(&map))) {
 		printf("\nFailed allocation.\n");
+		freeMap(&map);
 		return 0;
 	}
-	
-	int start[] = {0, DIM-1};
-	int goal[] = {DIM-1, 0};
-	
-	fillMap(map, start, goal);
-	
-	if (check(start, goal, map)) {
+	if (maskTable)
+		printf("Walkability masks computed in %f s (%.1f MB).\n", monotonicTime() - maskBegin, (double)map.rows*map.cols / 1048576.0);
+	times.load = monotonicTime() - begin;
+
+	// The abstraction is obtained before the starting point and the goal point are made free, so that it does not depend on them
+	begin = monotonicTime();
+	Hierarchy hierarchy;
+	memset(&hierarchy, 0, sizeof(hierarchy));
+	if (engine == ENGINE_HPA && !hierarchyPrepare(&hierarchy, &map, argv[optind])) {
+		freeMap(&map);
+		return 0;
+	}
+	Landmarks landmarks;
+	memset(&landmarks, 0, sizeof(landmarks));
+	if (numLandmarks > 0 && !landmarksPrepare(&landmarks, &map, numLandmarks, argv[optind])) {
+		hierarchyFree(&hierarchy);
+		freeMap(&map);
+		return 0;
+	}
+	times.init = monotonicTime() - begin;
+
+	if (queryFile != NULL) {
+		char resultFile[FILENAME_MAX];
+		batchFileName(argv[optind], resultFile, sizeof(resultFile));
+		bool ok = runBatch(&map, queryFile, engine, &hierarchy, (numLandmarks > 0) ? &landmarks : NULL, &anytime, resultFile);
+		landmarksFree(&landmarks);
+		hierarchyFree(&hierarchy);
+		freeMap(&map);
+		return ok ? 1 : 0;
+	}
+
+	int start[] = {0, map.cols-1};
+	int goal[] = {map.rows-1, 0};
+	if (args == 5) {
+		start[0] = atoi(argv[optind+1]);
+		start[1] = atoi(argv[optind+2]);
+		goal[0] = atoi(argv[optind+3]);
+		goal[1] = atoi(argv[optind+4]);
+	}
+
+	// The distances from the landmarks are not valid on a map in which the starting point or the goal point is made free
+	if (numLandmarks > 0 && check_position(&map, start) && check_position(&map, goal) && !(is_free(start, &map) && is_free(goal, &map))) {
+		printf("The starting point or the goal point is not free in the map: the landmarks are not used.\n");
+		landmarksFree(&landmarks);
+	}
+
+	// Start and goal points assumed as always free
+	if (check_position(&map, start))
+		mapSetCell(&map, start[0], start[1], true);
+	if (check_position(&map, goal))
+		mapSetCell(&map, goal[0], goal[1], true);
+
+	pathFileName(argv[optind], output.format, output.fname, sizeof(output.fname));
+
+	if (check(start, goal, &map)) {
 		// Execute the algorithm
-		search(map, start, goal);
+		if (editFile != NULL || randomChanges > 0)
+			replan(&map, start, goal, editFile, randomChanges, &output);
+		else {
+			search(&map, start, goal, engine, &hierarchy, (landmarks.numLandmarks > 0) ? &landmarks : NULL, &anytime, &times, &output);
+			printf("Times: load %f s, init %f s, search %f s, output %f s.\n", times.load, times.init, times.search, times.output);
+		}
 	}
 	else {
+		landmarksFree(&landmarks);
+		hierarchyFree(&hierarchy);
+		freeMap(&map);
 		return 0;
 	}
+	landmarksFree(&landmarks);
+	hierarchyFree(&hierarchy);
+	freeMap(&map);
 	return 1;
 }
@@ -0,0 +1,419 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <string.h>
+#include <unistd.h>
+
+#define OPEN_SET_INDEX int64_t		// Records of the cells (see below) and insertions of the open set are 64-bit
+#define OPEN_SET_SEQ uint64_t
+#define PATH_POSITION int64_t		// Positions of the cells of the path (see "path-output.h")
+
+#include "cell-state.h"
+#include "open-set.h"
+#include "path-output.h"
+#include "tiled-map.h"
+
+/* Out-of-core A*: the plain A* search of a-star-serial.c on a tiled map (see "tiled-map.h"), for the maps that do not fit in
+memory. The positions of the cells (row*cols + col) are 64-bit. The map is read through the cache of tiles, whose size is given
+with -c, so only the tiles around the frontier of the search are in memory. The state of the search is kept only for the cells
+reached: every cell reached has a record, appended to a vector, and the records are found from the positions of the cells with a
+hash table (open addressing, linear probing). The open set is the indexed binary heap of "open-set.h" with 64-bit indexes, whose
+nodes and handles refer to the records instead of the cells of the map. The cells are expanded in the same order as in a-star-serial.c
+(same neighbors, same heuristic, same ties in the open set), so on a map that fits in memory the path found is the same. */
+
+#define CACHE_MB 64				// Default size of the cache of tiles, in MB (option -c)
+#define ALLOC 1024				// Initial dimension of the vectors of the search
+#define TABLE_BITS 12			// Initial size of the hash table of the cells, as a power of 2
+
+// Directions of the neighbors of a cell (see "cell-state.h") in the order of the bits of a walkability mask (see "map.h"), as in
+// a-star-serial.c
+static const int neighborDirections[8] = {7, 0, 1, 6, 2, 5, 4, 3};
+
+typedef struct {
+	int64_t pos;				// Position of the cell
+	double g;					// Distance (cost) between the cell and the starting point
+	unsigned char parent;		// Direction from the cell to its parent (see "cell-state.h")
+	bool closed;				// The cell has been expanded
+} CellRecord;
+
+typedef struct {
+	TiledMap *map;				// Map, read through the cache of tiles
+	int64_t start[2], goal[2];	// Starting point and goal point (assumed as always free)
+	CellRecord *records;		// Records of the cells reached
+	int64_t numRecords;			// Number of records
+	int64_t allocRecords;		// Number of elements allocated for "records"
+	int64_t *table;				// Hash table: index + 1 of the record of a cell (0 if the slot is empty)
+	int tableBits;				// Number of slots of the table as a power of 2
+	OpenSet openSet;			// Open set, whose handles are allocated together with "records"
+	int64_t *path;				// Backward path (from goal to start)
+	int64_t pathSize;			// Number of cells of the path
+	int64_t allocPath;			// Number of elements allocated for "path"
+	long long expanded;			// Number of cells expanded
+} TiledSearch;
+
+/* Return the time of the monotonic clock, in seconds. */
+double monotonicTime(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* Reserve room for "size" elements of "elemSize" bytes in the vector "*v", of "*alloc" elements, doubling it if needed. It is
+returned false in case of failed allocation. */
+bool reserveVector(void **v, int64_t *alloc, int64_t size, size_t elemSize){
+	if (size <= *alloc)
+		return true;
+	int64_t newAlloc = (2 * *alloc > size) ? 2 * *alloc : size;
+	void *p = realloc(*v, (size_t)newAlloc*elemSize);
+	if (p == NULL)
+		return false;
+	*v = p;
+	*alloc = newAlloc;
+	return true;
+}
+
+/* Return the slot of the hash table from which the search of the cell "pos" starts. */
+static inline int64_t tableSlot(const TiledSearch *ts, int64_t pos){
+	return (int64_t)(((uint64_t)pos * 0x9E3779B97F4A7C15ULL) >> (64 - ts->tableBits));
+}
+
+/* Return the record of the cell "pos", or -1 if the cell has not been reached. */
+int64_t findRecord(const TiledSearch *ts, int64_t pos){
+	int64_t mask = ((int64_t)1 << ts->tableBits) - 1;
+	for (int64_t s = tableSlot(ts, pos); ts->table[s] != 0; s = (s + 1) & mask) {
+		if (ts->records[ts->table[s] - 1].pos == pos)
+			return ts->table[s] - 1;
+	}
+	return -1;
+}
+
+/* Double the hash table and insert the records again. It is returned false in case of failed allocation. */
+bool growTable(TiledSearch *ts){
+	int64_t *table = (int64_t *)calloc((size_t)1 << (ts->tableBits + 1), sizeof(int64_t));
+	if (table == NULL)
+		return false;
+	free(ts->table);
+	ts->table = table;
+	ts->tableBits++;
+	int64_t mask = ((int64_t)1 << ts->tableBits) - 1;
+	for (int64_t i = 0; i < ts->numRecords; i++) {
+		int64_t s = tableSlot(ts, ts->records[i].pos);
+		while (ts->table[s] != 0)
+			s = (s + 1) & mask;
+		ts->table[s] = i + 1;
+	}
+	return true;
+}
+
+/* Return the record of the cell "pos", creating it (not reached: g = infinity, no parent) if the cell has not been reached yet.
+The table is kept at most half full. It is returned -1 in case of failed allocation. */
+int64_t touchRecord(TiledSearch *ts, int64_t pos){
+	int64_t record = findRecord(ts, pos);
+	if (record >= 0)
+		return record;
+	int64_t allocRecords = ts->allocRecords;
+	if (!reserveVector((void **)&ts->records, &ts->allocRecords, ts->numRecords + 1, sizeof(CellRecord)))
+		return -1;
+	if (ts->allocRecords > allocRecords && !openSetGrowCells(&ts->openSet, allocRecords, ts->allocRecords))
+		return -1;
+	if (2*(ts->numRecords + 1) > ((int64_t)1 << ts->tableBits) && !growTable(ts))
+		return -1;
+
+	int64_t mask = ((int64_t)1 << ts->tableBits) - 1;
+	int64_t s = tableSlot(ts, pos);
+	while (ts->table[s] != 0)
+		s = (s + 1) & mask;
+	record = ts->numRecords++;
+	ts->table[s] = record + 1;
+	CellRecord cell = {pos, INFINITY, PARENT_NONE, false};
+	ts->records[record] = cell;
+	return record;
+}
+
+/* Return the value of "g" of the cell "pos" (infinity if it has not been reached). */
+double cellRecordG(const TiledSearch *ts, int64_t pos){
+	int64_t record = findRecord(ts, pos);
+	return (record >= 0) ? ts->records[record].g : INFINITY;
+}
+
+/* Check if the cell (r, c) is within the map and free (the starting point and the goal point are always free). If it is, it is
+returned true, otherwise false. */
+static inline bool cellFree(TiledSearch *ts, int64_t r, int64_t c){
+	if (r < 0 || r >= ts->map->rows || c < 0 || c >= ts->map->cols)
+		return false;
+	if ((r == ts->start[0] && c == ts->start[1]) || (r == ts->goal[0] && c == ts->goal[1]))
+		return true;
+	return tiledMapIsFree(ts->map, r, c);
+}
+
+/* Return the free neighbors of the cell (r, c) as a walkability mask (see "map.h"). */
+unsigned int freeNeighbors(TiledSearch *ts, int64_t r, int64_t c){
+	unsigned int mask = 0;
+	for (int i = 0; i < 8; i++) {
+		if (cellFree(ts, r + mapNeighborDelta[i][0], c + mapNeighborDelta[i][1]))
+			mask |= 1u << i;
+	}
+	return mask;
+}
+
+/* This function returns the Euclidean distance between the cell (r, c) and the goal point. */
+double heuristic(const TiledSearch *ts, int64_t r, int64_t c){
+	double deltaRow = (double)(r - ts->goal[0]), deltaCol = (double)(c - ts->goal[1]);
+	return sqrt(deltaRow*deltaRow + deltaCol*deltaCol);
+}
+
+/* Backward path (from goal to start) from the cell "pos": as in a-star-serial.c, the parent of every cell is its free neighbor
+having the lowest value of "g", starting from the one it was reached from. It is returned false in case of failed allocation. */
+bool buildPath(TiledSearch *ts, int64_t pos){
+	int64_t cols = ts->map->cols;
+	ts->pathSize = 0;
+	int64_t record = findRecord(ts, pos);
+	while (1) {
+		if (!reserveVector((void **)&ts->path, &ts->allocPath, ts->pathSize + 1, sizeof(int64_t)))
+			return false;
+		ts->path[ts->pathSize++] = pos;
+		int direction = ts->records[record].parent;
+		if (direction == PARENT_NONE || direction == PARENT_START)
+			return true;
+
+		int64_t r = pos / cols, c = pos % cols;
+		int64_t bpPos = (r + cellDeltaRow[direction])*cols + c + cellDeltaCol[direction];
+		double bpG = cellRecordG(ts, bpPos);
+		for (unsigned int mask = freeNeighbors(ts, r, c); mask != 0; mask &= mask - 1) {
+			int d = neighborDirections[__builtin_ctz(mask)];
+			int64_t cpPos = (r + cellDeltaRow[d])*cols + c + cellDeltaCol[d];
+			double cpG = cellRecordG(ts, cpPos);
+			if (cpG < bpG) {
+				bpPos = cpPos;
+				bpG = cpG;
+				ts->records[record].parent = d;
+			}
+		}
+		pos = bpPos;
+		record = findRecord(ts, pos);
+	}
+}
+
+/* A* search from the starting point to the goal point, as findPath() of a-star-serial.c with the plain A* engine. It is returned
+1 if a path is found (in "ts->path"), 0 if the goal point is not reachable and -1 in case of failed allocation. */
+int findPath(TiledSearch *ts){
+	int64_t cols = ts->map->cols;
+	int64_t posS = ts->start[0]*cols + ts->start[1];
+	int64_t posGoal = ts->goal[0]*cols + ts->goal[1];
+	int64_t recordS = touchRecord(ts, posS);
+	if (recordS < 0)
+		return -1;
+	ts->records[recordS].g = 0.0;
+	ts->records[recordS].parent = PARENT_START;
+	if (!openSetPush(&ts->openSet, recordS, 0.0))
+		return -1;
+
+	bool foundPath = false;
+	double bestG = INFINITY;		// Value of "g" of the goal point when it is expanded
+	while (1) {
+		// Condition that terminates the algorithm: the open set is empty or even its best cell can not improve the path found
+		if (ts->openSet.size == 0 || (foundPath && openSetTopF(&ts->openSet) >= bestG))
+			return foundPath ? 1 : 0;
+
+		int64_t record = openSetPop(&ts->openSet);
+		int64_t posC = ts->records[record].pos;
+		int64_t r = posC / cols, c = posC % cols;
+		ts->records[record].closed = true;
+		ts->expanded++;
+
+		if (posC == posGoal) {
+			if (!foundPath || ts->records[record].g < bestG) {
+				if (!buildPath(ts, posC))
+					return -1;
+				bestG = ts->records[record].g;
+			}
+			foundPath = true;
+		}
+
+		double gC = ts->records[record].g;
+		for (unsigned int mask = freeNeighbors(ts, r, c); mask != 0; mask &= mask - 1) {
+			int direction = neighborDirections[__builtin_ctz(mask)];
+			int64_t nr = r + cellDeltaRow[direction], nc = c + cellDeltaCol[direction];
+			int64_t n = touchRecord(ts, nr*cols + nc);
+			if (n < 0)
+				return -1;
+			CellRecord *cell = &ts->records[n];
+			if (cell->closed)
+				continue;
+
+			double tmpG = gC + cellMoveCost[direction];
+			double h = heuristic(ts, nr, nc);
+			bool newOpenSetCell = false;
+			if (openSetContains(&ts->openSet, n)) {
+				if (tmpG < cell->g)
+					cell->g = tmpG;
+			} else if (!foundPath || tmpG + h < bestG) {
+				cell->g = tmpG;
+				newOpenSetCell = true;
+			}
+			cell->parent = (direction + CELL_DIRECTIONS/2) % CELL_DIRECTIONS;	// Direction from the neighbor to "c"
+
+			if (newOpenSetCell) {
+				if (!openSetPush(&ts->openSet, n, cell->g + h))
+					return -1;
+			} else if (openSetContains(&ts->openSet, n)) {
+				openSetDecreaseKey(&ts->openSet, n, cell->g + h);
+			}
+		}
+	}
+}
+
+/* Print the path in the file and in the format (coords or runs) given by "output", with the writers of "path-output.h". It is
+returned false in case of error. */
+bool writeTiledPath(const PathOutput *output, const int64_t path[], int64_t pathSize, int64_t cols){
+	FILE *fp = fopen(output->fname, "w");
+	if (fp == NULL)
+		return false;
+	bool ok = (output->format == OUTPUT_COORDS) ? writeCoords(fp, cols, path, pathSize) : writeRuns(fp, cols, path, pathSize);
+	return (fclose(fp) == 0) && ok;
+}
+
+/* Free the vectors of the search. */
+void tiledSearchFree(TiledSearch *ts){
+	free(ts->records);
+	free(ts->table);
+	free(ts->path);
+	openSetFree(&ts->openSet);
+}
+
+/* Search of the path from "start" to "goal" on the tiled map, followed by the report of the cache of tiles and of the throughput
+of the search. The path is written in the file and in the format given by "output". */
+void search(TiledMap *map, int64_t start[], int64_t goal[], const PathOutput *output, double loadTime){
+	double begin = monotonicTime();
+	TiledSearch ts;
+	memset(&ts, 0, sizeof(ts));
+	ts.map = map;
+	ts.start[0] = start[0];
+	ts.start[1] = start[1];
+	ts.goal[0] = goal[0];
+	ts.goal[1] = goal[1];
+	ts.tableBits = TABLE_BITS;
+	ts.allocRecords = ts.allocPath = ALLOC;
+	if (!openSetInit(&ts.openSet, ALLOC, ALLOC)) {
+		printf("\nFailed allocation.\n");
+		return;
+	}
+	ts.records = (CellRecord *)malloc(ALLOC*sizeof(CellRecord));
+	ts.path = (int64_t *)malloc(ALLOC*sizeof(int64_t));
+	ts.table = (int64_t *)calloc((size_t)1 << TABLE_BITS, sizeof(int64_t));
+	if (ts.records == NULL || ts.path == NULL || ts.table == NULL) {
+		printf("\nFailed allocation.\n");
+		tiledSearchFree(&ts);
+		return;
+	}
+	double initTime = monotonicTime() - begin;
+
+	printf("Searching the best path...\n");
+	begin = monotonicTime();
+	int found = findPath(&ts);
+	double searchTime = monotonicTime() - begin;
+	printf("%lld cells expanded.\n", ts.expanded);
+
+	begin = monotonicTime();
+	if (found < 0) {
+		printf("\nFailed allocation.\n");
+	} else if (map->error) {
+		printf("\nError while reading the tiles of the map.\n");
+	} else if (found == 0) {
+		printf("\nGoal not reachable!\n");
+	} else {
+		double length = ts.records[findRecord(&ts, ts.path[0])].g;
+		double deltaRow = (double)(goal[0] - start[0]), deltaCol = (double)(goal[1] - start[1]);
+		double minDistance = sqrt(deltaRow*deltaRow + deltaCol*deltaCol);
+		printf("\nGoal reached through %lld intermedium cells. Path length %f over minimum distance %f (+ %.2f \%%).\n\n", (long long)ts.pathSize-2, length, minDistance, ((length / minDistance) - 1)*100);
+		printf("Printing the path on the file... ");
+		if (writeTiledPath(output, ts.path, ts.pathSize, map->cols))
+			printf("Path correctly printed on the file. File correctly closed.\n\n");
+		else
+			printf("Error while writing the output file %s.\n", output->fname);
+	}
+	double outputTime = monotonicTime() - begin;
+
+	const TiledMapStats *st = &map->stats;
+	double tileMB = TILE_WORDS*sizeof(uint64_t) / 1048576.0;
+	double stateMB = (ts.allocRecords*(sizeof(CellRecord) + sizeof(int64_t)) + ((size_t)sizeof(int64_t) << ts.tableBits) + ts.openSet.alloc*sizeof(OpenSetNode)) / 1048576.0;
+	printf("Tiles: %lld cells read, %.4f %% of them from the cache; %lld tiles read (%.1f MB in %.3f s), %lld evicted, %d in the cache (%.1f MB).\n",
+		st->lookups, (st->lookups > 0) ? 100.0 * (st->lookups - st->misses) / st->lookups : 0.0, st->misses, st->misses*tileMB, st->readTime,
+		st->evictions, map->used, map->used*tileMB);
+	printf("Search: %lld cells reached (%.1f MB of state), %.0f cells expanded per second.\n", (long long)ts.numRecords, stateMB,
+		(searchTime > 0) ? ts.expanded / searchTime : 0.0);
+	printf("Times: load %f s, init %f s, search %f s, output %f s.\n", loadTime, initTime, searchTime, outputTime);
+	tiledSearchFree(&ts);
+}
+
+/* Print how the program has to be launched. */
+void usage(const char *program){
+	printf("Usage: %s [-c <cache MB>] [-o coords|runs] <tiled map file> [<start row> <start col> <goal row> <goal col>]\n", program);
+	printf("The map is a tiled map (see create-map -t and convert-map -t), whose tiles are read on demand in a cache of -c MB\n");
+	printf("(default: %d). By default the starting point is the top right corner of the map and the goal point is the bottom\n", CACHE_MB);
+	printf("left one. The option -o selects the format of the output file (default: runs).\n");
+}
+
+int main (int argc, char *argv[]) {
+	PathOutput output;
+	output.format = OUTPUT_RUNS;
+	double cacheMB = CACHE_MB;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "c:o:")) != -1) {
+		bool valid = false;
+		if (opt == 'c')
+			valid = (cacheMB = atof(optarg)) > 0.0;
+		else if (opt == 'o')
+			valid = parseOutputFormat(optarg, &output.format) && (output.format == OUTPUT_COORDS || output.format == OUTPUT_RUNS);
+		if (!valid) {
+			usage(argv[0]);
+			return 0;
+		}
+	}
+
+	int args = argc - optind;		// Number of arguments after the options
+	if (args != 1 && args != 5) {
+		usage(argv[0]);
+		return 0;
+	}
+
+	printf("Opening file %s...\n", argv[optind]);
+	double begin = monotonicTime();
+	TiledMap map;
+	if (!tiledMapOpen(&map, argv[optind], (size_t)(cacheMB * 1048576))) {
+		return 0;
+	}
+	double loadTime = monotonicTime() - begin;
+	printf("Map %lldx%lld in %lld tiles of %dx%d cells, cache of %d tiles.\n", (long long)map.rows, (long long)map.cols,
+		(long long)(map.tileRows*map.tileCols), TILE_SIDE, TILE_SIDE, map.slots);
+
+	int64_t start[] = {0, map.cols-1};
+	int64_t goal[] = {map.rows-1, 0};
+	if (args == 5) {
+		start[0] = atoll(argv[optind+1]);
+		start[1] = atoll(argv[optind+2]);
+		goal[0] = atoll(argv[optind+3]);
+		goal[1] = atoll(argv[optind+4]);
+	}
+
+	if (start[0] < 0 || start[0] >= map.rows || start[1] < 0 || start[1] >= map.cols || goal[0] < 0 || goal[0] >= map.rows
+			|| goal[1] < 0 || goal[1] >= map.cols) {
+		printf("ERROR: start or goal point is out of the map!\n");
+		tiledMapClose(&map);
+		return 0;
+	}
+	if (start[0] == goal[0] && start[1] == goal[1]) {
+		printf("ERROR: start and goal points coincide!\n");
+		tiledMapClose(&map);
+		return 0;
+	}
+
+	pathFileName(argv[optind], output.format, output.fname, sizeof(output.fname));
+	search(&map, start, goal, &output, loadTime);
+	tiledMapClose(&map);
+	return 1;
+}
@@ -0,0 +1,55 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+/* Arena (bump) allocator for the scratch memory of a search: a single block, sized in advance, from which the vectors of the
+search are taken one after the other. All of them are released in one step, emptying the arena for the next search
+(arenaReset()) or freeing it (arenaFree()), so that a search whose vectors come from an arena costs no call to malloc() and
+free() once the arena exists. The vectors taken from an arena can not be reallocated or freed one by one. */
+
+#define ARENA_ALIGN 64			// Alignment of every vector taken from an arena (a cache line)
+
+typedef struct {
+	char *base;					// Block of memory of the arena
+	size_t size;				// Number of bytes of "base"
+	size_t used;				// Number of bytes already taken
+} Arena;
+
+/* Return the number of bytes taken from an arena by a vector of "bytes" bytes, i.e., "bytes" rounded up to the alignment. The
+size of an arena is the sum of those of the vectors that will be taken from it. */
+static inline size_t arenaBytes(size_t bytes){
+	return (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+/* Allocation of an empty arena of "size" bytes. It is returned false in case of failed allocation. */
+static inline bool arenaInit(Arena *a, size_t size){
+	a->size = arenaBytes(size > 0 ? size : 1);
+	a->used = 0;
+	a->base = (char *)aligned_alloc(ARENA_ALIGN, a->size);
+	return a->base != NULL;
+}
+
+/* Take a vector of "bytes" bytes from the arena. It is returned NULL if the arena does not have room for it. */
+static void *arenaAlloc(Arena *a, size_t bytes){
+	if (arenaBytes(bytes) > a->size - a->used)
+		return NULL;
+	void *p = a->base + a->used;
+	a->used += arenaBytes(bytes);
+	return p;
+}
+
+/* Release all the vectors taken from the arena, which can then be used for a new search. */
+static inline void arenaReset(Arena *a){
+	a->used = 0;
+}
+
+/* Free the memory of the arena. */
+static inline void arenaFree(Arena *a){
+	free(a->base);
+	a->base = NULL;
+	a->size = a->used = 0;
+}
+
+#endif
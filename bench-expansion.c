@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include "map.h"
+#include "cell-state.h"
+
+#define REPETITIONS 10		// Default number of passes over the map
+
+/* Microbenchmark of the neighbor expansion: every free cell of the map is expanded, i.e., its free neighbors are found and
+their positions are computed, first probing the neighbors with bounds checks as the searches did before the walkability grid
+(double loop over deltaRow and deltaCol, check of the position and of the cell), then with the walkability grid and its border
+(see "map.h"), with the directions of 8-connectivity and of 4-connectivity, and finally visiting the bits set in the
+walkability mask of the cell, obtained from the grid or read from the table of the masks (see mapMaskInit()), also without
+the diagonal moves that cut a corner. The sum of the positions of the neighbors found is printed too, so that the work can
+not be optimized away and the methods with the same moves can be checked against each other. */
+
+typedef struct {
+	long long neighbors;		// Number of free neighbors found
+	long long checksum;			// Sum of their positions
+} Expansion;
+
+/* Check if a cell is inside the map. If it is, it is returned true, otherwise false. */
+bool check_position (Map *map, int cell[]) {
+	return cell[0] >= 0 && cell[0] < map->rows && cell[1] >= 0 && cell[1] < map->cols;
+}
+
+/* Check if a cell is free. If it is, it is returned true, otherwise false. */
+bool is_free (int cell[], Map *map) {
+	return mapIsFree(map, cell[0], cell[1]);
+}
+
+/* Check if a neighbor is valid (i.e., if it is inside the map) and free. If it is, it is returned true, otherwise false. */
+bool check_a_neighbor(int deltaRow, int deltaCol, int cell[], Map *map){
+	int neighbor[2] = {cell[0] + deltaRow, cell[1] + deltaCol};
+	return check_position(map, neighbor) && is_free(neighbor, map);
+}
+
+/* Expansion of every free cell probing its neighbors with bounds checks. */
+Expansion expandProbing(Map *map){
+	Expansion e = {0, 0};
+	for (int r = 0; r < map->rows; r++) {
+		for (int c = 0; c < map->cols; c++) {
+			if (!mapIsFree(map, r, c))
+				continue;
+			int cell[2] = {r, c};
+			for (int deltaRow = -1; deltaRow <= 1; deltaRow++) {
+				for (int deltaCol = -1; deltaCol <= 1; deltaCol++) {
+					if ((deltaRow != 0 || deltaCol != 0) && check_a_neighbor(deltaRow, deltaCol, cell, map)) {
+						e.neighbors++;
+						e.checksum += (r + deltaRow)*map->cols + c + deltaCol;
+					}
+				}
+			}
+		}
+	}
+	return e;
+}
+
+/* Expansion of every free cell with the walkability grid, in the directions "directions" (CONNECTIVITY of them). The list
+of directions is a compile-time constant, so the loop over it is unrolled and the only branch left is the walkability test. */
+#define EXPAND_BORDER(name, CONNECTIVITY, ...)												\
+Expansion name(Map *map){																	\
+	static const int directions[CONNECTIVITY] = {__VA_ARGS__};								\
+	int cellOffset[CELL_DIRECTIONS], walkOffset[CELL_DIRECTIONS];							\
+	for (int d = 0; d < CELL_DIRECTIONS; d++) {												\
+		cellOffset[d] = cellDeltaRow[d]*map->cols + cellDeltaCol[d];						\
+		walkOffset[d] = cellDeltaRow[d]*(map->cols + 2) + cellDeltaCol[d];					\
+	}																						\
+	Expansion e = {0, 0};																	\
+	for (int r = 0; r < map->rows; r++) {													\
+		const unsigned char *walk = map->walk + mapWalkIndex(map, r, 0);					\
+		for (int c = 0; c < map->cols; c++) {												\
+			if (!walk[c])																	\
+				continue;																	\
+			int pos = r*map->cols + c;														\
+			_Pragma("GCC unroll 8")															\
+			for (int i = 0; i < CONNECTIVITY; i++) {										\
+				if (walk[c + walkOffset[directions[i]]]) {									\
+					e.neighbors++;															\
+					e.checksum += pos + cellOffset[directions[i]];							\
+				}																			\
+			}																				\
+		}																					\
+	}																						\
+	return e;																				\
+}
+
+EXPAND_BORDER(expandBorder8, 8, 7, 0, 1, 6, 2, 5, 4, 3)
+EXPAND_BORDER(expandBorder4, 4, 0, 6, 2, 4)
+
+/* Expansion of every free cell visiting the bits set in its walkability mask, given by the expression "MASK" of the map, the
+position "pos" and the row and column "r" and "c" of the cell. The neighbor of bit i is the one of mapNeighborDelta[i]. */
+#define EXPAND_MASK(name, MASK)																\
+Expansion name(Map *map){																	\
+	int offset[8];																			\
+	for (int i = 0; i < 8; i++)																\
+		offset[i] = mapNeighborDelta[i][0]*map->cols + mapNeighborDelta[i][1];				\
+	Expansion e = {0, 0};																	\
+	for (int r = 0; r < map->rows; r++) {													\
+		for (int c = 0; c < map->cols; c++) {												\
+			int pos = r*map->cols + c;														\
+			if (!mapIsFree(map, r, c))														\
+				continue;																	\
+			for (unsigned int mask = (MASK); mask != 0; mask &= mask - 1) {					\
+				e.neighbors++;																\
+				e.checksum += pos + offset[__builtin_ctz(mask)];							\
+			}																				\
+		}																					\
+	}																						\
+	return e;																				\
+}
+
+EXPAND_MASK(expandWalkMask, mapWalkMask(map, r, c))
+EXPAND_MASK(expandMaskTable, map->mask[pos])
+EXPAND_MASK(expandMaskStrict, mapMaskNoCornerCutting(map->mask[pos]))
+
+/* Run "repetitions" passes of an expansion method over the map and print its throughput. */
+void bench(const char *name, Expansion (*expand)(Map *), Map *map, long long freeCells, int repetitions){
+	struct timespec begin, end;
+	Expansion e = {0, 0};
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	for (int i = 0; i < repetitions; i++)
+		e = expand(map);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+	printf("%-10s %8.2f M expansions/s  %6.2f ns/expansion  (%lld neighbors, checksum %lld)\n", name,
+		freeCells*repetitions / seconds / 1e6, seconds*1e9 / (freeCells*repetitions), e.neighbors, e.checksum);
+}
+
+/* Main function. Usage: bench-expansion <map file> [<repetitions>] */
+int main(int argc, char *argv[]){
+	if (argc != 2 && argc != 3) {
+		printf("Usage: %s <map file> [<repetitions>]\n", argv[0]);
+		exit(1);
+	}
+	int repetitions = (argc == 3) ? atoi(argv[2]) : REPETITIONS;
+	if (repetitions <= 0) {
+		printf("%s is not a valid number of repetitions.\n", argv[2]);
+		exit(1);
+	}
+
+	Map map;
+	if (!fillMap(&map, argv[1]))
+		exit(1);
+	if (!mapBorderInit(&map)) {
+		printf("\nFailed allocation.\n");
+		freeMap(&map);
+		exit(1);
+	}
+	struct timespec begin, end;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	if (!mapMaskInit(&map)) {
+		printf("\nFailed allocation.\n");
+		freeMap(&map);
+		exit(1);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+	printf("Walkability masks computed in %f s (%.1f MB).\n", seconds, (double)map.rows*map.cols / 1048576.0);
+
+	long long freeCells = mapFreeCells(&map);
+	printf("Expanding the %lld free cells %d times...\n", freeCells, repetitions);
+	bench("probing", expandProbing, &map, freeCells, repetitions);
+	bench("border-8", expandBorder8, &map, freeCells, repetitions);
+	bench("border-4", expandBorder4, &map, freeCells, repetitions);
+	bench("walk-mask", expandWalkMask, &map, freeCells, repetitions);
+	bench("mask-table", expandMaskTable, &map, freeCells, repetitions);
+	bench("mask-strict", expandMaskStrict, &map, freeCells, repetitions);
+	freeMap(&map);
+	return 0;
+}
@@ -0,0 +1,572 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <signal.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#define REPETITIONS 3				// Default number of runs of every engine on every map
+#define TOLERANCE 10.0				// Default tolerance of the comparison with the baseline, in percent
+#define MIN_DIFFERENCE 0.002		// Differences of time below this (in seconds) are never regressions (noise of the clock)
+#define TIMEOUT 600					// Default time limit of a run, in seconds
+#define MAX_REPETITIONS 100
+#define NAME_LENGTH 256
+
+/* End-to-end benchmark of the a-star programs: every engine of a-star-serial and a-star-parallel is run on every map of a
+directory (default: ./maps), several times, each run as a separate process with the default starting point and goal point and
+the "runs" output format. From the output of every run are taken the times of its phases (the "Times:" line: loading of the
+map, preparation of the search, search and writing of the output file), the number of cells expanded and the length of the
+path, and from the operating system the peak resident memory of the process. When the programs are compiled with
+-DSEARCH_STATS=1 (see "search-stats.h"), the allocations of memory made by the search and the time spent in them are taken from
+the line of the statistics too. The median of every time over the runs is
+written in a results file, in JSON or CSV (by the extension of its name). With -c the results are compared with a baseline
+file written before (in either format) and every time, number of expanded cells or peak memory that has grown more than the
+tolerance is reported as a regression, as every path length that has changed; the exit status is then 1 if there is any. */
+
+typedef struct {
+	const char *name;			// Name of the program in the results
+	const char *executable;		// Path of its executable
+	const char *engines[8];		// Engines that it supports (NULL-terminated)
+} Program;
+
+typedef struct {
+	char program[16];
+	char engine[16];
+	char map[NAME_LENGTH];		// File name of the map, without the directory
+	int runs;					// Number of successful runs
+	double load;				// Median times of the phases and of the whole process, in seconds
+	double init;
+	double search;
+	double output;
+	double total;
+	long long expanded;			// Cells expanded (-1 if the engine does not report them)
+	double cost;				// Length of the path (-1 if the goal point is not reachable)
+	long peakRss;				// Peak resident memory over the runs, in KB
+	long long allocations;		// Allocations of memory made by the search (-1 if the statistics are not compiled)
+	double allocTime;			// Median time spent in them, in seconds
+} Result;
+
+typedef struct {
+	double times[6];			// Load, init, search, output, total and time of the allocations
+	long long expanded;
+	double cost;
+	long peakRss;
+	long long allocations;
+} Sample;
+
+/* Return the time of the monotonic clock, in seconds. */
+double monotonicTime(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* Read the string of the key "key" of a JSON object written by writeResults() (or of the line of the statistics of a search) in "value" (of "size" characters). */
+bool jsonString(const char *line, const char *key, char *value, int size){
+	char pattern[64];
+	snprintf(pattern, sizeof(pattern), "\"%s\": \"", key);
+	const char *p = strstr(line, pattern);
+	if (p == NULL)
+		return false;
+	p += strlen(pattern);
+	int len = strcspn(p, "\"");
+	if (len >= size)
+		return false;
+	memcpy(value, p, len);
+	value[len] = '\0';
+	return true;
+}
+
+/* Read the number of the key "key" of a JSON object written by writeResults() (or of the line of the statistics) in "value". */
+bool jsonNumber(const char *line, const char *key, double *value){
+	char pattern[64];
+	snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+	const char *p = strstr(line, pattern);
+	return p != NULL && sscanf(p + strlen(pattern), "%lf", value) == 1;
+}
+
+/* Parse the output "text" of a run of an a-star program into "sample" (the total time and the peak memory are not filled).
+It is returned false if the output does not contain the times of the phases, i.e., the run has not completed a search. */
+bool parseOutput(const char *text, Sample *sample){
+	const char *times = strstr(text, "Times: ");
+	if (times == NULL || sscanf(times, "Times: load %lf s, init %lf s, search %lf s, output %lf s.", &sample->times[0],
+			&sample->times[1], &sample->times[2], &sample->times[3]) != 4)
+		return false;
+
+	// The last count of expanded cells is the total one (the anytime search prints one per round, with the cumulative count)
+	sample->expanded = -1;
+	for (const char *p = strstr(text, " cells expanded"); p != NULL; p = strstr(p + 1, " cells expanded")) {
+		const char *digits = p;
+		while (digits > text && digits[-1] >= '0' && digits[-1] <= '9')
+			digits--;
+		if (digits < p)
+			sample->expanded = atoll(digits);
+	}
+
+	const char *length = strstr(text, "Path length ");
+	sample->cost = -1.0;
+	if (length != NULL)
+		sscanf(length, "Path length %lf", &sample->cost);
+
+	const char *stats = strstr(text, "{\"engine\": ");
+	double allocations;
+	sample->allocations = -1;
+	sample->times[5] = 0.0;
+	if (stats != NULL && jsonNumber(stats, "allocations", &allocations) && jsonNumber(stats, "alloc_time", &sample->times[5]))
+		sample->allocations = allocations;
+	return true;
+}
+
+/* Run the engine "engine" of the executable "executable" on the map "map" as a separate process, whose output is read through
+a pipe, and fill "sample". The process is killed after "timeout" seconds. It is returned false if the run fails. */
+bool runOnce(const char *executable, const char *engine, const char *map, int timeout, Sample *sample){
+	int fd[2];
+	if (pipe(fd) != 0) {
+		printf("Error while creating a pipe.\n");
+		return false;
+	}
+	double begin = monotonicTime();
+	pid_t pid = fork();
+	if (pid < 0) {
+		printf("Error while creating a process.\n");
+		close(fd[0]);
+		close(fd[1]);
+		return false;
+	}
+	if (pid == 0) {
+		dup2(fd[1], STDOUT_FILENO);
+		close(fd[0]);
+		close(fd[1]);
+		alarm(timeout);			// The alarm survives the exec and its default action terminates the process
+		execl(executable, executable, "-e", engine, "-o", "runs", map, (char *)NULL);
+		_exit(127);
+	}
+	close(fd[1]);
+
+	// Output of the run, read until the end of the pipe
+	size_t size = 0, alloc = 65536;
+	char *text = malloc(alloc);
+	ssize_t n = 0;
+	while (text != NULL && (n = read(fd[0], text + size, alloc - size - 1)) > 0) {
+		size += n;
+		if (size + 1 == alloc) {
+			char *larger = realloc(text, alloc * 2);
+			if (larger == NULL)
+				free(text);
+			text = larger;
+			alloc *= 2;
+		}
+	}
+	close(fd[0]);
+
+	int status;
+	struct rusage usage;
+	if (wait4(pid, &status, 0, &usage) < 0 || text == NULL) {
+		printf("Error while running %s.\n", executable);
+		free(text);
+		return false;
+	}
+	sample->times[4] = monotonicTime() - begin;
+	sample->peakRss = usage.ru_maxrss;
+	text[size] = '\0';
+
+	bool ok = true;
+	if (WIFSIGNALED(status)) {
+		printf("%s -e %s %s: killed by signal %d%s.\n", executable, engine, map, WTERMSIG(status), (WTERMSIG(status) == SIGALRM) ? " (time limit)" : "");
+		ok = false;
+	} else if (WIFEXITED(status) && WEXITSTATUS(status) == 127) {
+		printf("Error while launching %s.\n", executable);
+		ok = false;
+	} else if (!parseOutput(text, sample)) {
+		printf("%s -e %s %s: the search has not completed.\n", executable, engine, map);
+		ok = false;
+	}
+	free(text);
+	return ok;
+}
+
+/* Comparison of two doubles for qsort(). */
+int compareDoubles(const void *a, const void *b){
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/* Comparison of two strings for qsort(). */
+int compareNames(const void *a, const void *b){
+	return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/* Median of the "index"-th time of "num" samples. */
+double medianTime(Sample samples[], int num, int index){
+	double values[MAX_REPETITIONS];
+	for (int i = 0; i < num; i++)
+		values[i] = samples[i].times[index];
+	qsort(values, num, sizeof(double), compareDoubles);
+	return (num % 2 == 1) ? values[num / 2] : (values[num/2 - 1] + values[num / 2]) / 2;
+}
+
+/* Run "repetitions" times the engine "engine" of the program "program" on the map "dir"/"map" and summarize the runs in
+"result". It is returned false if any run fails. */
+bool benchEngine(const Program *program, const char *engine, const char *dir, const char *map, int repetitions, int timeout, Result *result){
+	char path[FILENAME_MAX];
+	snprintf(path, sizeof(path), "%s/%s", dir, map);
+	memset(result, 0, sizeof(*result));
+	snprintf(result->program, sizeof(result->program), "%s", program->name);
+	snprintf(result->engine, sizeof(result->engine), "%s", engine);
+	snprintf(result->map, sizeof(result->map), "%s", map);
+
+	Sample samples[MAX_REPETITIONS];
+	for (int i = 0; i < repetitions; i++) {
+		if (!runOnce(program->executable, engine, path, timeout, &samples[i]))
+			return false;
+		if (samples[i].peakRss > result->peakRss)
+			result->peakRss = samples[i].peakRss;
+	}
+	result->runs = repetitions;
+	result->load = medianTime(samples, repetitions, 0);
+	result->init = medianTime(samples, repetitions, 1);
+	result->search = medianTime(samples, repetitions, 2);
+	result->output = medianTime(samples, repetitions, 3);
+	result->total = medianTime(samples, repetitions, 4);
+	result->allocTime = medianTime(samples, repetitions, 5);
+	result->expanded = samples[0].expanded;
+	result->cost = samples[0].cost;
+	result->allocations = samples[0].allocations;
+	return true;
+}
+
+/* Check if a file of the maps directory is a map for the searches in memory, i.e., a regular file that is not the abstraction
+(.hpa) or the landmarks (.alt) of a map, nor a tiled map (.tiles, searched only by a-star-tiled). If it is, it is returned true,
+otherwise false. */
+bool isMapFile(const char *dir, const char *name){
+	char path[FILENAME_MAX];
+	struct stat st;
+	const char *dot = strrchr(name, '.');
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	return name[0] != '.' && stat(path, &st) == 0 && S_ISREG(st.st_mode)
+		&& (dot == NULL || (strcmp(dot, ".hpa") != 0 && strcmp(dot, ".alt") != 0 && strcmp(dot, ".tiles") != 0));
+}
+
+/* List the maps of the directory "dir" in alphabetical order. It is returned their number (-1 in case of error); the names are
+returned in "*maps" and have to be freed. */
+int listMaps(const char *dir, char ***maps){
+	DIR *d = opendir(dir);
+	if (d == NULL) {
+		printf("Error while opening the directory %s.\n", dir);
+		return -1;
+	}
+	int num = 0, alloc = 16;
+	*maps = malloc(alloc * sizeof(char *));
+	struct dirent *entry;
+	while (*maps != NULL && (entry = readdir(d)) != NULL) {
+		if (!isMapFile(dir, entry->d_name))
+			continue;
+		if (num == alloc) {
+			char **larger = realloc(*maps, 2 * alloc * sizeof(char *));
+			if (larger == NULL) {
+				while (num > 0)
+					free((*maps)[--num]);
+				free(*maps);
+			}
+			*maps = larger;
+			alloc *= 2;
+		}
+		if (*maps != NULL && ((*maps)[num] = strdup(entry->d_name)) != NULL)
+			num++;
+	}
+	closedir(d);
+	if (*maps == NULL) {
+		printf("\nFailed allocation.\n");
+		return -1;
+	}
+	qsort(*maps, num, sizeof(char *), compareNames);
+	return num;
+}
+
+/* Check if the name of a file ends with ".csv". If it does, it is returned true, otherwise false. */
+bool isCsv(const char *fname){
+	size_t len = strlen(fname);
+	return len >= 4 && strcmp(fname + len - 4, ".csv") == 0;
+}
+
+/* Write "num" results in the file "fname", in CSV if its name ends with ".csv", otherwise in JSON (an array with one object per
+line). It is returned false in case of error. */
+bool writeResults(Result results[], int num, const char *fname){
+	FILE *fp = fopen(fname, "w");
+	if (fp == NULL)
+		return false;
+	bool csv = isCsv(fname);
+	if (csv)
+		fprintf(fp, "program,engine,map,runs,load,init,search,output,total,expanded,cost,peak_rss_kb,allocations,alloc_time\n");
+	else
+		fprintf(fp, "[\n");
+	for (int i = 0; i < num; i++) {
+		Result *r = &results[i];
+		if (csv)
+			fprintf(fp, "%s,%s,%s,%d,%f,%f,%f,%f,%f,%lld,%f,%ld,%lld,%f\n", r->program, r->engine, r->map, r->runs, r->load, r->init, r->search, r->output,
+				r->total, r->expanded, r->cost, r->peakRss, r->allocations, r->allocTime);
+		else
+			fprintf(fp, "{\"program\": \"%s\", \"engine\": \"%s\", \"map\": \"%s\", \"runs\": %d, \"load\": %f, \"init\": %f, \"search\": %f, \"output\": %f, \"total\": %f, \"expanded\": %lld, \"cost\": %f, \"peak_rss_kb\": %ld, \"allocations\": %lld, \"alloc_time\": %f}%s\n",
+				r->program, r->engine, r->map, r->runs, r->load, r->init, r->search, r->output, r->total, r->expanded, r->cost, r->peakRss,
+				r->allocations, r->allocTime, (i + 1 < num) ? "," : "");
+	}
+	if (!csv)
+		fprintf(fp, "]\n");
+	return fclose(fp) == 0;
+}
+
+/* Parse a line of a results file, JSON or CSV, into "r". It is returned false if the line is not a result. The allocations
+are optional, since they are missing in the files written before they were recorded. */
+bool parseResult(const char *line, bool csv, Result *r){
+	r->allocations = -1;
+	r->allocTime = 0.0;
+	if (csv)
+		return sscanf(line, "%15[^,],%15[^,],%255[^,],%d,%lf,%lf,%lf,%lf,%lf,%lld,%lf,%ld,%lld,%lf", r->program, r->engine, r->map, &r->runs,
+			&r->load, &r->init, &r->search, &r->output, &r->total, &r->expanded, &r->cost, &r->peakRss, &r->allocations, &r->allocTime) >= 12;
+
+	double runs, expanded, peakRss, allocations;
+	bool ok = jsonString(line, "program", r->program, sizeof(r->program)) && jsonString(line, "engine", r->engine, sizeof(r->engine))
+		&& jsonString(line, "map", r->map, sizeof(r->map)) && jsonNumber(line, "runs", &runs) && jsonNumber(line, "load", &r->load)
+		&& jsonNumber(line, "init", &r->init) && jsonNumber(line, "search", &r->search) && jsonNumber(line, "output", &r->output)
+		&& jsonNumber(line, "total", &r->total) && jsonNumber(line, "expanded", &expanded) && jsonNumber(line, "cost", &r->cost)
+		&& jsonNumber(line, "peak_rss_kb", &peakRss);
+	r->runs = runs;
+	r->expanded = expanded;
+	r->peakRss = peakRss;
+	if (ok && jsonNumber(line, "allocations", &allocations) && jsonNumber(line, "alloc_time", &r->allocTime))
+		r->allocations = allocations;
+	return ok;
+}
+
+/* Read the results file "fname" written by writeResults() (the format is recognised by its first character). It is returned the
+number of results (-1 in case of error); the results are returned in "*results" and have to be freed. */
+int readResults(const char *fname, Result **results){
+	FILE *fp = fopen(fname, "r");
+	if (fp == NULL) {
+		printf("Error while opening the baseline file %s.\n", fname);
+		return -1;
+	}
+	char line[1024];
+	int first = fgetc(fp);
+	bool csv = (first != '[');
+	if (first != EOF)
+		ungetc(first, fp);
+	int num = 0, alloc = 64;
+	*results = malloc(alloc * sizeof(Result));
+	while (*results != NULL && fgets(line, sizeof(line), fp) != NULL) {
+		if (num == alloc) {
+			Result *larger = realloc(*results, 2 * alloc * sizeof(Result));
+			if (larger == NULL)
+				free(*results);
+			*results = larger;
+			alloc *= 2;
+		}
+		if (*results != NULL && parseResult(line, csv, &(*results)[num]))
+			num++;
+	}
+	fclose(fp);
+	if (*results == NULL) {
+		printf("\nFailed allocation.\n");
+		return -1;
+	}
+	return num;
+}
+
+/* Check a value against the one of the baseline: if it has grown more than "tolerance" percent (and more than "minimum"), the
+change is appended to "report" and it is returned true. */
+bool regressed(const char *what, double value, double base, double tolerance, double minimum, char *report, size_t size){
+	if (value <= base * (1 + tolerance / 100) || value - base <= minimum)
+		return false;
+	size_t len = strlen(report);
+	if (base > 0)
+		snprintf(report + len, size - len, " %s +%.1f%%", what, (value / base - 1) * 100);
+	else
+		snprintf(report + len, size - len, " %s %g (was 0)", what, value);
+	return true;
+}
+
+/* Compare "num" results with the "numBase" ones of the baseline and print a line for each of them. It is returned the number
+of regressions found. */
+int compareResults(Result results[], int num, Result base[], int numBase, double tolerance){
+	int regressions = 0;
+	printf("\nComparison with the baseline (tolerance %.1f%%):\n", tolerance);
+	for (int i = 0; i < num; i++) {
+		Result *r = &results[i], *b = NULL;
+		for (int j = 0; j < numBase && b == NULL; j++) {
+			if (strcmp(r->program, base[j].program) == 0 && strcmp(r->engine, base[j].engine) == 0 && strcmp(r->map, base[j].map) == 0)
+				b = &base[j];
+		}
+		printf("%-8s %-6s %-24s ", r->program, r->engine, r->map);
+		if (b == NULL) {
+			printf("not in the baseline\n");
+			continue;
+		}
+		char report[512] = "";
+		bool worse = false;
+		if (r->runs == 0 || b->runs == 0) {
+			worse = (r->runs == 0 && b->runs > 0);
+			snprintf(report, sizeof(report), " %s", (r->runs == 0) ? (b->runs > 0 ? "failed" : "failed in the baseline too") : "failed in the baseline");
+		} else {
+			if (r->cost != b->cost && (r->cost < 0 || b->cost < 0 || r->cost - b->cost > 1e-6 || b->cost - r->cost > 1e-6)) {
+				snprintf(report, sizeof(report), " path length %f (was %f)", r->cost, b->cost);
+				worse = true;
+			}
+			worse |= regressed("load", r->load, b->load, tolerance, MIN_DIFFERENCE, report, sizeof(report));
+			worse |= regressed("init", r->init, b->init, tolerance, MIN_DIFFERENCE, report, sizeof(report));
+			worse |= regressed("search", r->search, b->search, tolerance, MIN_DIFFERENCE, report, sizeof(report));
+			worse |= regressed("output", r->output, b->output, tolerance, MIN_DIFFERENCE, report, sizeof(report));
+			worse |= regressed("total", r->total, b->total, tolerance, MIN_DIFFERENCE, report, sizeof(report));
+			worse |= regressed("expanded", r->expanded, b->expanded, tolerance, 0, report, sizeof(report));
+			worse |= regressed("peak memory", r->peakRss, b->peakRss, tolerance, 0, report, sizeof(report));
+			if (r->allocations >= 0 && b->allocations >= 0)
+				worse |= regressed("allocations", r->allocations, b->allocations, tolerance, 0, report, sizeof(report));
+		}
+		if (worse)
+			regressions++;
+		printf("%s%s (search %.2f ms, was %.2f ms)\n", worse ? "REGRESSION:" : "ok", report, r->search*1000, b->search*1000);
+	}
+	printf("%d regressions.\n", regressions);
+	return regressions;
+}
+
+/* Print how the program has to be launched. */
+void usage(const char *program){
+	printf("Usage: %s [-n <repetitions>] [-e <engine>[,<engine>...]] [-o <results file>] [-c <baseline file>] [-t <tolerance>]\n", program);
+	printf("       [-T <seconds>] [-s <serial executable>] [-p <parallel executable>] [<maps directory>]\n");
+	printf("Every engine of the serial and of the parallel program (default: ./a-star-serial and ./a-star-parallel, a program is\n");
+	printf("skipped if its executable is missing or the path given is empty) is run -n times (default: %d) on every map of the\n", REPETITIONS);
+	printf("directory (default: maps) and the median times of the phases, the cells expanded, the path length, the peak memory\n");
+	printf("and, if the programs are compiled with -DSEARCH_STATS=1, the allocations of the search are written in the results\n");
+	printf("file (default: bench-results.json; CSV if its name ends with .csv). With -e only the engines listed are run. With -c\n");
+	printf("the results are compared with the baseline file and the times, cells expanded, memory and allocations grown more\n");
+	printf("than -t percent (default: %.0f), as well as the changed path lengths, are reported as\n", TOLERANCE);
+	printf("regressions. Every run is killed after -T seconds (default: %d).\n", TIMEOUT);
+}
+
+/* Check if the engine "engine" is in the comma-separated list "list" (NULL: all the engines). */
+bool selected(const char *list, const char *engine){
+	if (list == NULL)
+		return true;
+	size_t len = strlen(engine);
+	for (const char *p = list; p != NULL; p = strchr(p, ',')) {
+		if (*p == ',')
+			p++;
+		if (strncmp(p, engine, len) == 0 && (p[len] == ',' || p[len] == '\0'))
+			return true;
+	}
+	return false;
+}
+
+int main(int argc, char *argv[]){
+	Program programs[] = {
+		{"serial", "./a-star-serial", {"astar", "jps", "hpa", "bidir", "ara", NULL}},
+		{"parallel", "./a-star-parallel", {"astar", "jps", "hpa", "bidir", "mq", "ara", NULL}}
+	};
+	int numPrograms = sizeof(programs) / sizeof(programs[0]);
+	int repetitions = REPETITIONS;
+	int timeout = TIMEOUT;
+	double tolerance = TOLERANCE;
+	const char *engines = NULL;
+	const char *resultFile = "bench-results.json";
+	const char *baselineFile = NULL;
+
+	int opt;
+	while ((opt = getopt(argc, argv, "c:e:n:o:p:s:t:T:")) != -1) {
+		bool valid = true;
+		if (opt == 'c')
+			baselineFile = optarg;
+		else if (opt == 'e')
+			engines = optarg;
+		else if (opt == 'n')
+			valid = (repetitions = atoi(optarg)) > 0 && repetitions <= MAX_REPETITIONS;
+		else if (opt == 'o')
+			resultFile = optarg;
+		else if (opt == 'p')
+			programs[1].executable = optarg;
+		else if (opt == 's')
+			programs[0].executable = optarg;
+		else if (opt == 't')
+			valid = (tolerance = atof(optarg)) >= 0;
+		else if (opt == 'T')
+			valid = (timeout = atoi(optarg)) > 0;
+		else
+			valid = false;
+		if (!valid) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (argc - optind > 1) {
+		usage(argv[0]);
+		return 1;
+	}
+	const char *dir = (optind < argc) ? argv[optind] : "maps";
+
+	char **maps;
+	int numMaps = listMaps(dir, &maps);
+	if (numMaps < 0)
+		return 1;
+	printf("%d maps found in %s, %d runs of every engine on every map.\n", numMaps, dir, repetitions);
+
+	int numResults = 0;
+	Result *results = malloc((size_t)numPrograms * 8 * (numMaps > 0 ? numMaps : 1) * sizeof(Result));
+	if (results == NULL) {
+		printf("\nFailed allocation.\n");
+		return 1;
+	}
+	for (int p = 0; p < numPrograms; p++) {
+		if (programs[p].executable[0] == '\0')
+			continue;
+		if (access(programs[p].executable, X_OK) != 0) {
+			printf("%s not found: the %s program is skipped.\n", programs[p].executable, programs[p].name);
+			continue;
+		}
+		for (int m = 0; m < numMaps; m++) {
+			for (int e = 0; programs[p].engines[e] != NULL; e++) {
+				if (!selected(engines, programs[p].engines[e]))
+					continue;
+				Result *r = &results[numResults++];
+				bool ok = benchEngine(&programs[p], programs[p].engines[e], dir, maps[m], repetitions, timeout, r);
+				printf("%-8s %-6s %-24s ", r->program, r->engine, r->map);
+				if (ok && r->allocations >= 0)
+					printf("load %8.2f ms  init %8.2f ms  search %8.2f ms  output %6.2f ms  %9lld expanded  length %10.3f  %7ld KB  %lld allocations in %.3f ms\n",
+						r->load*1000, r->init*1000, r->search*1000, r->output*1000, r->expanded, r->cost, r->peakRss, r->allocations, r->allocTime*1000);
+				else if (ok)
+					printf("load %8.2f ms  init %8.2f ms  search %8.2f ms  output %6.2f ms  %9lld expanded  length %10.3f  %7ld KB\n",
+						r->load*1000, r->init*1000, r->search*1000, r->output*1000, r->expanded, r->cost, r->peakRss);
+				else
+					printf("failed\n");
+			}
+		}
+	}
+	for (int m = 0; m < numMaps; m++)
+		free(maps[m]);
+	free(maps);
+
+	int status = 0;
+	if (writeResults(results, numResults, resultFile)) {
+		printf("Results written in the file %s.\n", resultFile);
+	} else {
+		printf("Error while writing the output file %s.\n", resultFile);
+		status = 1;
+	}
+
+	if (baselineFile != NULL) {
+		Result *base;
+		int numBase = readResults(baselineFile, &base);
+		if (numBase < 0)
+			status = 1;
+		else {
+			if (compareResults(results, numResults, base, numBase, tolerance) > 0)
+				status = 1;
+			free(base);
+		}
+	}
+	free(results);
+	return status;
+}
@@ -0,0 +1,104 @@
+#ifndef CELL_STATE_H
+#define CELL_STATE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+/* State of the cells of the map during a search, kept as a structure of arrays with one element per cell (in position
+row*cols + col). Only what can not be obtained in another way is stored:
+	g			distance (cost) between the cell and the starting point
+	parent		direction from the cell to its parent (one byte), PARENT_NONE if the cell has not been reached and
+				PARENT_START for the starting point, whose parent is the cell itself
+Row and column of a cell are obtained from its position, the heuristic "h" is recomputed when it is needed and "f" is only
+kept in the open set. The parents of Jump Point Search are not adjacent cells, so for that engine also their positions are
+stored (see "jump-points.h").
+The cells are initialized lazily: every search has a new generation number and the values of a cell are valid only if the cell
+has been stamped with the current generation, otherwise the cell has not been reached yet (g = CELL_UNREACHED, no parent).
+Starting a new search thus costs as much as the cells reached by it, not as the whole map. */
+
+#define CELL_DIRECTIONS 8
+#define PARENT_NONE 8			// The cell has not been reached
+#define PARENT_START 9			// The cell is the starting point
+#define CELL_UNREACHED INFINITY	// Value of "g" of a cell not reached yet (higher than the cost of any path, whatever the size of the map)
+
+// Directions, clockwise from north (row 0 is north, the last column is east): N, NE, E, SE, S, SW, W, NW
+static const int cellDeltaRow[CELL_DIRECTIONS] = {-1, -1, 0, 1, 1, 1, 0, -1};
+static const int cellDeltaCol[CELL_DIRECTIONS] = {0, 1, 1, 1, 0, -1, -1, -1};
+static const double cellMoveCost[CELL_DIRECTIONS] = {1.0, 1.4142135623730951, 1.0, 1.4142135623730951, 1.0, 1.4142135623730951, 1.0, 1.4142135623730951};
+
+typedef struct {
+	double *g;					// Distance (cost) between a cell and the starting point
+	unsigned char *parent;		// Direction from a cell to its parent
+	int *jumpParent;			// Position of the parent of a cell - only for Jump Point Search (NULL otherwise)
+	unsigned int *stamp;		// Generation in which the values of a cell have been written
+	unsigned int generation;	// Generation of the current search
+} CellState;
+
+/* Obtain the index of the direction (deltaRow, deltaCol), with deltaRow and deltaCol in {-1, 0, 1} but not both 0. */
+static inline int cellDirection(int deltaRow, int deltaCol){
+	static const unsigned char index[3][3] = {{7, 0, 1}, {6, PARENT_NONE, 2}, {5, 4, 3}};
+	return index[deltaRow+1][deltaCol+1];
+}
+
+/* Allocation of the state of "numCells" cells (the positions of the parents only if "jumpParents" is true). No cell is stamped,
+so cellStateReset() has to be called before every search. It is returned false in case of failed allocation. */
+static inline bool cellStateInit(CellState *cs, int numCells, bool jumpParents){
+	cs->generation = 0;
+	cs->g = (double *)malloc((size_t)numCells*sizeof(double));
+	cs->parent = (unsigned char *)malloc((size_t)numCells*sizeof(unsigned char));
+	cs->jumpParent = jumpParents ? (int *)malloc((size_t)numCells*sizeof(int)) : NULL;
+	cs->stamp = (unsigned int *)calloc(numCells, sizeof(unsigned int));
+	if (cs->g == NULL || cs->parent == NULL || (jumpParents && cs->jumpParent == NULL) || cs->stamp == NULL) {
+		free(cs->g);
+		free(cs->parent);
+		free(cs->jumpParent);
+		free(cs->stamp);
+		return false;
+	}
+	return true;
+}
+
+/* Free the vectors of the state of the cells. */
+static inline void cellStateFree(CellState *cs){
+	free(cs->g);
+	free(cs->parent);
+	free(cs->jumpParent);
+	free(cs->stamp);
+}
+
+/* Start a new generation, i.e., mark all the cells of a map of "numCells" cells as not reached. Only when the generation
+number wraps around the stamps are actually cleared. */
+static inline void cellStateReset(CellState *cs, int numCells){
+	if (++cs->generation == 0) {
+		memset(cs->stamp, 0, (size_t)numCells*sizeof(unsigned int));
+		cs->generation = 1;
+	}
+}
+
+/* Check if a cell has been reached in the current search. If it is, it is returned true, otherwise false. */
+static inline bool cellReached(const CellState *cs, int pos){
+	return cs->stamp[pos] == cs->generation;
+}
+
+/* Prepare a cell to be written in the current search: if it has not been reached yet, its values are initialized. */
+static inline void cellTouch(CellState *cs, int pos){
+	if (cs->stamp[pos] != cs->generation) {
+		cs->stamp[pos] = cs->generation;
+		cs->g[pos] = CELL_UNREACHED;
+		cs->parent[pos] = PARENT_NONE;
+	}
+}
+
+/* Return the value of "g" of a cell (CELL_UNREACHED if it has not been reached in the current search). */
+static inline double cellG(const CellState *cs, int pos){
+	return cellReached(cs, pos) ? cs->g[pos] : CELL_UNREACHED;
+}
+
+/* Return the direction of the parent of a cell (PARENT_NONE if it has not been reached in the current search). */
+static inline int cellParent(const CellState *cs, int pos){
+	return cellReached(cs, pos) ? cs->parent[pos] : PARENT_NONE;
+}
+
+#endif
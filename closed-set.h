@@ -0,0 +1,90 @@
+#ifndef CLOSED_SET_H
+#define CLOSED_SET_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Closed set of the A* search, implemented as a bitmap with one bit per cell of the map, so that checking whether a cell
+has already been considered is a single load instead of a scan of all the cells closed so far. The words of the bitmap that
+have been written are recorded, so that emptying the closed set for a new search only costs as much as the cells closed by the
+previous one. */
+
+typedef struct {
+	uint64_t *bits;				// Bit "pos" is set if the cell in position "pos" is in the closed set
+	int size;					// Number of cells in the closed set
+	int *dirty;					// Indices of the words of "bits" that are not zero
+	int numDirty;				// Number of elements of "dirty"
+} ClosedSet;
+
+/* Allocation of an empty closed set for a map of "numCells" cells. It is returned false in case of failed allocation. */
+static bool closedSetInit(ClosedSet *cs, int numCells){
+	cs->size = 0;
+	cs->numDirty = 0;
+	cs->bits = (uint64_t *)calloc((numCells + 63) / 64, sizeof(uint64_t));
+	cs->dirty = (int *)malloc((numCells + 63) / 64 * sizeof(int));
+	if (cs->bits == NULL || cs->dirty == NULL) {
+		free(cs->bits);
+		free(cs->dirty);
+		return false;
+	}
+	return true;
+}
+
+/* Empty the closed set, so that it can be used for a new search. Only the words of the bitmap written by the previous search
+are cleared. */
+static void closedSetClear(ClosedSet *cs){
+	for (int i = 0; i < cs->numDirty; i++)
+		cs->bits[cs->dirty[i]] = 0;
+	cs->numDirty = 0;
+	cs->size = 0;
+}
+
+/* Free the vectors of the closed set. */
+static void closedSetFree(ClosedSet *cs){
+	free(cs->bits);
+	free(cs->dirty);
+}
+
+/* Check if a cell is in the closed set. If it is, it is returned true, otherwise false. */
+static inline bool closedSetContains(const ClosedSet *cs, int pos){
+	return (cs->bits[pos >> 6] >> (pos & 63)) & 1;
+}
+
+/* Add a cell to the closed set (nothing is done if the cell is already in it). */
+static inline void closedSetAdd(ClosedSet *cs, int pos){
+	uint64_t mask = (uint64_t)1 << (pos & 63);
+	if (!(cs->bits[pos >> 6] & mask)) {
+		if (cs->bits[pos >> 6] == 0)
+			cs->dirty[cs->numDirty++] = pos >> 6;
+		cs->bits[pos >> 6] |= mask;
+		cs->size++;
+	}
+}
+
+/* Add a cell to the closed set "cs" of one of two searches running at the same time in different threads (see the bidirectional
+search) and check if the cell is also in the closed set "other" of the other search. Every closed set is written only by its
+own search: the word of "cs" is written and the one of "other" is read atomically and in sequentially consistent order, so that
+when both searches close the same cell at least one of them finds it in both closed sets (and every value written by the other
+search before closing the cell is visible). */
+static inline bool closedSetAddShared(ClosedSet *cs, const ClosedSet *other, int pos){
+	uint64_t mask = (uint64_t)1 << (pos & 63);
+	uint64_t word = cs->bits[pos >> 6];
+	if (!(word & mask)) {
+		if (word == 0)
+			cs->dirty[cs->numDirty++] = pos >> 6;
+#ifdef _OPENMP
+		#pragma omp atomic write seq_cst
+#endif
+		cs->bits[pos >> 6] = word | mask;
+		cs->size++;
+	}
+	uint64_t otherWord;
+#ifdef _OPENMP
+	#pragma omp atomic read seq_cst
+#endif
+	otherWord = other->bits[pos >> 6];
+	return (otherWord & mask) != 0;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "map.h"
+#include "tiled-map.h"
+
+/* Obtain the percentage of obstacles from the name of a map created by create-map.c, i.e., "map-dim%d-obst%d". If the name
+does not contain it, MAP_UNKNOWN_OBST is returned. */
+int obstaclesFromName(const char *fname){
+	const char *base = strrchr(fname, '/');
+	base = (base == NULL) ? fname : base + 1;
+	const char *obst = strstr(base, "obst");
+	int obstacles;
+	if (obst != NULL && sscanf(obst, "obst%d", &obstacles) == 1)
+		return obstacles;
+	return MAP_UNKNOWN_OBST;
+}
+
+/* Main function. The text map given on the command line is read and written in the binary format (see "map.h"), either in
+the file given as second argument or in a file with the same name and the ".bin" extension. With the "-t" option the map (text
+or binary) is written in the tiled format instead (see "tiled-map.h"), by default in a file with the ".tiles" extension. */
+int main(int argc, char *argv[]){
+	bool tiled = (argc > 1 && strcmp(argv[1], "-t") == 0);
+	int a = tiled ? 2 : 1;		// Position of the map given on the command line
+	if (argc != a+1 && argc != a+2) {
+		printf("Usage: %s [-t] <map> [<converted map>]\n", argv[0]);
+		exit(1);
+	}
+
+	Map map;
+	if (!fillMap(&map, argv[a]))
+		exit(1);
+	if (map.obstacles == MAP_UNKNOWN_OBST)
+		map.obstacles = obstaclesFromName(argv[a]);
+
+	char fname[FILENAME_MAX];
+	if (argc == a+2) {
+		snprintf(fname, sizeof(fname), "%s", argv[a+1]);
+	} else {
+		size_t len = strlen(argv[a]);
+		if (tiled && len > 4 && strcmp(argv[a] + len - 4, ".bin") == 0)
+			len -= 4;
+		snprintf(fname, sizeof(fname), "%.*s%s", (int)len, argv[a], tiled ? ".tiles" : ".bin");
+	}
+
+	printf("Writing the %s map... ", tiled ? "tiled" : "binary");
+	if (!(tiled ? saveTiledMap(&map, fname) : saveBinaryMap(&map, fname))) {
+		printf("Error while writing the file %s.\n", fname);
+		freeMap(&map);
+		exit(1);
+	}
+	printf("The map has been written in the file \"%s\".\n", fname);
+	freeMap(&map);
+	return 0;
+}
@@ -1,97 +1,232 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
-#define DIM 1000		// Dimension of rows and columns of the map
-#define OBSTACLES 10	// Percentage of obstacles in the map
-#define SEED 0
-
-/* This function is used to create a map of a given dimension and a given percentage of obstacles. If the percentage of obstacles is greater
-than zero, then the cells within the map are marked as free [true] or occupied [false], otherwise, if it is equal to zero, all cells are marked
-as free. Finally, an error message is reported if the percentage of obstacles is less than zero. */
-bool createMap(bool map[]){
-	int r,c,elem;
-	int free_cell_num = 0;
-	int obstPercent = OBSTACLES;
-	
-	printf("Filling map... ");
-	
-	/* If we enter this if() statement, then the percentage of obstacles is greater than zero. Consequently, a certain number of cells, proportional
-	to the percentage of obstacles, will be indicated as occupied [false], while the rest will be indicated as free [true]. */
-	if(obstPercent > 0){
-		int obst = 10000/obstPercent;		// obst = 10000/obstPercent is an obstacle
-		srand(SEED);						// Not casual		
-		
-		for (r=0; r<DIM; r++){
-			for (c=0; c<DIM; c++){
-				elem=rand()%obst;			// Pseudo-random integer in the range [0, obst]
-				if (elem < 100){
-					map[r*DIM+c] = false;	// Cell occupied, i.e., there is an obstacle
-				} else {
-					map[r*DIM+c] = true;	// Cell free
-					free_cell_num++;
-				}
+#include "map.h"
+#include "tiled-map.h"
+
+#define DIM 1000		// Default dimension of rows and columns of the map
+#define OBSTACLES 10	// Default percentage of obstacles in the map
+#define SEED 0			// Default seed of the pseudo-random generator
+#define BLOCK_BYTES (16 << 20)	// Size of the block of rows generated at once and then written in the file
+
+typedef enum {
+	FORMAT_TEXT,				// One "c " per cell (see printTextRow())
+	FORMAT_BINARY,				// One bit per cell (see "map.h")
+	FORMAT_TILED				// One bit per cell, in tiles (see "tiled-map.h")
+} MapFormat;
+
+static const char *mapExtensions[] = {"", ".bin", ".tiles"};
+
+/* Pseudo-random value of the cell "index" (r*dim + c) of the map created with the seed "seed". It is the output number "index" of
+the SplitMix64 generator seeded with "seed": the state after "index" steps is computed directly and then mixed, so the value of a
+cell depends only on the seed and on its position (a counter-based generator). The rows of the map can then be generated in any
+order and by any number of threads, always with the same result, which does not depend on the rand() of the C library either. */
+static inline uint64_t cellRandom(uint64_t seed, uint64_t index){
+	uint64_t z = seed + (index + 1) * 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/* This function fills the row "r" of a map of dim x dim cells in "bits", with the layout of the rows of the binary format (see
+"map.h"): every cell is occupied with probability obstPercent/100, otherwise it is free. If the percentage of obstacles is
+zero all cells are free. The number of free cells of the row is returned. */
+long long createRow(uint64_t bits[], int r, int dim, int obstPercent, unsigned int seed){
+	int words = (dim + 63) / 64;
+	long long freeCells = 0;
+
+	for (int w = 0; w < words; w++){
+		uint64_t word = 0;
+		int cells = (dim - 64*w < 64) ? dim - 64*w : 64;
+		for (int i = 0; i < cells; i++){
+			uint64_t index = (uint64_t)r*dim + 64*w + i;
+			bool free = ((cellRandom(seed, index) >> 32) * 100 >> 32) >= (uint64_t)obstPercent;	// Highest 32 bits mapped onto 0..99
+			word |= (uint64_t)free << i;
+		}
+		bits[w] = word;
+		freeCells += __builtin_popcountll(word);
+	}
+	return freeCells;
+}
+
+/* This function writes the row "bits" of dim cells in the text format, i.e., "c " for every cell (c = 1 if the cell is free, 0 if
+it is occupied) and a new line, in "text" (2*dim + 1 characters). */
+void printTextRow(char text[], const uint64_t bits[], int dim){
+	for (int c = 0; c < dim; c++){
+		text[2*c] = '0' + ((bits[c >> 6] >> (c & 63)) & 1);
+		text[2*c + 1] = ' ';
+	}
+	text[2*dim] = '\n';
+}
+
+/* This function creates a map of dim x dim cells with the given percentage of obstacles and seed, and writes it in the file
+"fname", in the given format. The map is never kept in memory as a whole: the rows are generated in blocks of about BLOCK_BYTES
+bytes, the rows of a block by all the threads at the same time (see cellRandom()), and every block is written in the file before
+the next one is generated. In the binary format the checksum of the payload is computed block by block and the header is written
+again at the end with it; in the tiled format the blocks are made of whole rows of tiles, which are rearranged into the tiles
+before being written. It is returned false in case of error. */
+bool createMap(const char *fname, int dim, int obstPercent, unsigned int seed, MapFormat format){
+	bool binary = (format != FORMAT_TEXT);
+	int words = (dim + 63) / 64;
+	int64_t tileCols = (dim + TILE_SIDE - 1) / TILE_SIDE;
+	size_t rowBytes = binary ? words*sizeof(uint64_t) : 2*(size_t)dim + 1;
+	int blockRows = (rowBytes >= BLOCK_BYTES) ? 1 : (int)(BLOCK_BYTES / rowBytes);
+	if (format == FORMAT_TILED)
+		blockRows = (blockRows > TILE_SIDE) ? blockRows - blockRows % TILE_SIDE : TILE_SIDE;
+	else if (blockRows > dim)
+		blockRows = dim;
+
+	uint64_t *bits = (uint64_t *)malloc((size_t)blockRows*words*sizeof(uint64_t));
+	char *text = binary ? NULL : (char *)malloc((size_t)blockRows*rowBytes);
+	uint64_t *tiles = (format == FORMAT_TILED) ? (uint64_t *)malloc((size_t)tileCols*TILE_WORDS*sizeof(uint64_t)) : NULL;
+	if (bits == NULL || (!binary && text == NULL) || (format == FORMAT_TILED && tiles == NULL)) {
+		printf("\nFailed allocation of the block of rows.\n");
+		free(bits);
+		free(text);
+		free(tiles);
+		return false;
+	}
+
+	FILE *fp = fopen(fname, binary ? "wb" : "w");
+	if (fp == NULL){
+		printf("Error opening file.\n");
+		free(bits);
+		free(text);
+		free(tiles);
+		return false;
+	}
+
+	MapHeader header;
+	memcpy(header.magic, MAP_MAGIC, 4);
+	header.version = MAP_VERSION;
+	header.rows = dim;
+	header.cols = dim;
+	header.obstacles = obstPercent;
+	header.seed = seed;
+	header.checksum = 14695981039346656037ULL;		// 64-bit FNV-1a of the payload, as in mapChecksum()
+	TiledMapHeader tiledHeader;
+	tiledMapHeaderInit(&tiledHeader, dim, dim, obstPercent, seed);
+
+	printf("Filling and printing the map... ");
+	fflush(stdout);
+	bool ok = true;
+	if (format == FORMAT_BINARY)
+		ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+	else if (format == FORMAT_TILED)
+		ok = fwrite(&tiledHeader, sizeof(tiledHeader), 1, fp) == 1 && fseek(fp, TILED_DATA_OFFSET, SEEK_SET) == 0;
+	long long freeCells = 0;
+
+	for (int first = 0; ok && first < dim; first += blockRows){
+		int rows = (dim - first < blockRows) ? dim - first : blockRows;
+		long long blockFree = 0;
+
+#ifdef _OPENMP
+		#pragma omp parallel for schedule(static) reduction(+:blockFree)
+#endif
+		for (int i = 0; i < rows; i++){
+			blockFree += createRow(bits + (size_t)i*words, first + i, dim, obstPercent, seed);
+			if (!binary)
+				printTextRow(text + (size_t)i*rowBytes, bits + (size_t)i*words, dim);
+		}
+		freeCells += blockFree;
+
+		if (format == FORMAT_TILED) {
+			for (int i = 0; ok && i < rows; i += TILE_SIDE) {
+				tiledMapPackRows(bits + (size_t)i*words, words, (rows - i < TILE_SIDE) ? rows - i : TILE_SIDE, tileCols, tiles);
+				ok = fwrite(tiles, sizeof(uint64_t), (size_t)tileCols*TILE_WORDS, fp) == (size_t)tileCols*TILE_WORDS;
 			}
-		}	
-	} 
-	/* If we enter this else if() statement, then the percentage of obstacles is equal to zero. Consequently, all cells are marked as free [true]. */
-	else if (obstPercent == 0) {			// No obstacles
-		free_cell_num = DIM*DIM;
-		
-		for (r=0; r<DIM; r++){
-			for (c=0; c<DIM; c++){
-				map[r*DIM+c] = true;		// Cell free
+		} else if (binary) {
+			for (size_t i = 0; i < (size_t)rows*words; i++) {
+				header.checksum ^= bits[i];
+				header.checksum *= 1099511628211ULL;
 			}
+			ok = fwrite(bits, sizeof(uint64_t), (size_t)rows*words, fp) == (size_t)rows*words;
+		} else {
+			ok = fwrite(text, 1, (size_t)rows*rowBytes, fp) == (size_t)rows*rowBytes;
 		}
-	} 
-	/* If we enter this else statement, then the percentage of obstacles is less than zero. Consequently, an error message is reported. */
-	else {
-		printf("\nError! The percentage of obstacles must be greater than or equal to zero.\n");
+	}
+
+	if (ok && format == FORMAT_BINARY)
+		ok = fseek(fp, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, fp) == 1;
+	ok = (fclose(fp) == 0) && ok;
+	free(bits);
+	free(text);
+	free(tiles);
+
+	if (!ok) {
+		printf("Error writing file.\n");
 		return false;
 	}
-	
-	printf("Map %dx%d filled with %d free cells.\n", DIM, DIM, free_cell_num);
+	printf("Map %dx%d filled with %lld free cells.\n", dim, dim, freeCells);
 	return true;
 }
 
-/* Main function. Here the space needed for the map is allocated. Subsequently, if the creation of the map was successful, a file is created in 
-the "maps" folder in which the map is printed. */
-int main(){
-	bool *map;
-	map = (bool *)malloc(DIM*DIM*sizeof(bool));
-	
-	if(map == NULL) {
-		printf("\nFailed allocation of the map.\n");
-		exit(1);
-	}
+/* Return the time of the monotonic clock, in seconds. */
+double monotonicTime(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
 
-	if(!createMap(map)){
-		exit(1);
-	} else {
-		FILE *fp;
-		char fname[40];
-		sprintf(fname,"./maps/map-dim%d-obst%d",DIM,OBSTACLES);
-		fp = fopen(fname,"w");
-		
-		if (fp == NULL){
-			printf("Error opening file.\n");
+/* Print how the program has to be launched. */
+void usage(const char *program){
+	printf("Usage: %s [-b | -t] [-o <map file>] [<dimension> [<percentage of obstacles> [<seed>]]]\n", program);
+	printf("A map of <dimension> x <dimension> cells (default: %d) is created with the given percentage of obstacles (default: %d)\n", DIM, OBSTACLES);
+	printf("and seed (default: %d) and written in ./maps/map-dim<dimension>-obst<percentage>, or in the file given with -o.\n", SEED);
+	printf("With -b the map is written in the binary format (in ./maps/map-dim<dimension>-obst<percentage>.bin by default), with\n");
+	printf("-t in the tiled one, for the maps larger than the memory (in ./maps/map-dim<dimension>-obst<percentage>.tiles).\n");
+	printf("The same dimension, percentage and seed always give the same map, whatever the number of threads (OMP_NUM_THREADS).\n");
+}
+
+/* Main function. The dimension of the map, the percentage of obstacles and the seed can be given on the command line, otherwise the
+default values defined above are used; with the "-b" or "-t" option the map is written in the binary or tiled format instead of
+the text one, and with the "-o" option in the file given instead of the "maps" folder. */
+int main(int argc, char *argv[]){
+	MapFormat format = FORMAT_TEXT;
+	const char *output = NULL;		// File of the map (option -o)
+
+	int opt;
+	while ((opt = getopt(argc, argv, "bo:t")) != -1) {
+		if (opt == 'b' && format == FORMAT_TEXT) {
+			format = FORMAT_BINARY;
+		} else if (opt == 't' && format == FORMAT_TEXT) {
+			format = FORMAT_TILED;
+		} else if (opt == 'o') {
+			output = optarg;
+		} else {
+			usage(argv[0]);
 			exit(1);
 		}
-		
-		printf("Printing the map... ");		
-		int r,c;
-		
-		for(r=0; r<DIM; r++){
-			for(c=0; c<DIM; c++){
-				fprintf(fp, "%d ", map[r*DIM+c]);
-			}
-			fprintf(fp,"\n");
-		}
-		
-		printf("The map has been printed. You can find the file \"map-dim%d-obst%d\" inside the \"maps\" folder.\n",DIM,OBSTACLES);
-		fclose(fp);
-		printf("File closed successfully.\n");
 	}
+
+	int a = optind;		// Position of the first numeric argument
+	long dim = (argc > a) ? strtol(argv[a], NULL, 10) : DIM;
+	int obstacles = (argc > a+1) ? atoi(argv[a+1]) : OBSTACLES;
+	unsigned int seed = (argc > a+2) ? (unsigned int)strtoul(argv[a+2], NULL, 10) : SEED;
+
+	if (argc > a+3 || dim <= 0 || dim > INT32_MAX / 2 || obstacles > 100) {
+		usage(argv[0]);
+		exit(1);
+	}
+	if (obstacles < 0) {
+		printf("Error! The percentage of obstacles must be greater than or equal to zero.\n");
+		exit(1);
+	}
+
+	char fname[FILENAME_MAX];
+	if (output != NULL)
+		snprintf(fname, sizeof(fname), "%s", output);
+	else
+		snprintf(fname, sizeof(fname), "./maps/map-dim%ld-obst%d%s", dim, obstacles, mapExtensions[format]);
+
+	double start = monotonicTime();
+	if (!createMap(fname, (int)dim, obstacles, seed, format))
+		exit(1);
+	printf("The map has been printed in %.3f s. You can find it in the file \"%s\".\n", monotonicTime() - start, fname);
 	return 0;
 }
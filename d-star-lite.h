@@ -0,0 +1,307 @@
+#ifndef D_STAR_LITE_H
+#define D_STAR_LITE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "map.h"
+
+/* Incremental replanning with D* Lite (Koenig and Likhachev). The search runs backwards, from the goal point towards the
+starting point, and for every cell it keeps two values:
+	g		distance (cost) from the cell to the goal point, as far as the search has computed it
+	rhs		one-step lookahead of g: the lowest cost of a move towards a neighbor plus the value of "g" of that neighbor
+			(0 for the goal point, INFINITY for an obstacle)
+A cell is consistent when g = rhs; the inconsistent cells are kept in a priority queue ordered by the key
+[min(g, rhs) + h; min(g, rhs)], where "h" is the Euclidean distance from the starting point. When some cells of the map change,
+only the values of "rhs" of those cells and of their neighbors are recomputed, and the search goes on from the inconsistent
+cells until the starting point is consistent again: the work done is proportional to the region whose distances have changed,
+not to the whole map. A move between two cells is possible when both of them are free, as in the other searches, so a change of
+a cell changes the cost of the moves from and towards all its neighbors. */
+
+#define D_STAR_TOLERANCE 1e-9	// Relative difference under which the first component of a key is considered equal to the one of
+								// the starting point (the keys of the cells along a straight line are equal up to rounding)
+
+typedef struct {
+	double k1;					// First component of the key - min(g, rhs) + h
+	double k2;					// Second component of the key - min(g, rhs), used to break ties
+	int pos;					// Position of the cell
+} DStarNode;
+
+typedef struct {
+	double *g;					// Distance (cost) between a cell and the goal point
+	double *rhs;				// One-step lookahead of "g"
+	DStarNode *heap;			// Inconsistent cells - binary heap, the cell having the lowest key is in the first position
+	int *handle;				// Position of every cell inside "heap" (-1 if the cell is consistent)
+	int size;					// Number of cells in the heap
+	int alloc;					// Number of elements allocated for "heap"
+	int numCells;				// Number of cells of the map
+	int start;					// Position of the starting point
+	int goal;					// Position of the goal point
+	unsigned int neighborMask;	// Bits of the walkability masks of the moves allowed by the connectivity (see "map.h")
+	int offset[8];				// Offset of the neighbor of bit i of a walkability mask
+	long long expanded;			// Number of cells expanded by the last computation
+} DStarLite;
+
+/* Return true if the node "a" has a lower key than the node "b", false otherwise. */
+static inline bool dStarLiteBefore(const DStarNode *a, const DStarNode *b){
+	return a->k1 < b->k1 || (a->k1 == b->k1 && a->k2 < b->k2);
+}
+
+/* Place "node" at position "i" of the heap and update its handle. */
+static inline void dStarLitePlace(DStarLite *ds, int i, DStarNode node){
+	ds->heap[i] = node;
+	ds->handle[node.pos] = i;
+}
+
+/* Move the node in position "i" of the heap up or down until the heap property is restored. */
+static void dStarLiteSift(DStarLite *ds, int i){
+	DStarNode node = ds->heap[i];
+	while (i > 0 && dStarLiteBefore(&node, &ds->heap[(i - 1) / 2])) {
+		dStarLitePlace(ds, i, ds->heap[(i - 1) / 2]);
+		i = (i - 1) / 2;
+	}
+	while (1) {
+		int child = 2*i + 1;
+		if (child >= ds->size)
+			break;
+		if (child + 1 < ds->size && dStarLiteBefore(&ds->heap[child+1], &ds->heap[child]))
+			child++;
+		if (!dStarLiteBefore(&ds->heap[child], &node))
+			break;
+		dStarLitePlace(ds, i, ds->heap[child]);
+		i = child;
+	}
+	dStarLitePlace(ds, i, node);
+}
+
+/* Remove the cell "pos" from the heap. */
+static void dStarLiteRemove(DStarLite *ds, int pos){
+	int i = ds->handle[pos];
+	ds->handle[pos] = -1;
+	if (--ds->size > i) {
+		dStarLitePlace(ds, i, ds->heap[ds->size]);
+		dStarLiteSift(ds, i);
+	}
+}
+
+/* Key of the cell "pos" of the map "map". */
+static inline DStarNode dStarLiteKey(const DStarLite *ds, const Map *map, int pos){
+	double m = (ds->g[pos] < ds->rhs[pos]) ? ds->g[pos] : ds->rhs[pos];
+	double deltaRow = pos / map->cols - ds->start / map->cols, deltaCol = pos % map->cols - ds->start % map->cols;
+	DStarNode node = {m + sqrt(deltaRow*deltaRow + deltaCol*deltaCol), m, pos};
+	return node;
+}
+
+/* Return the walkability mask of the cell "pos" restricted to the moves allowed by the connectivity: from the table of the
+masks if it has been built, otherwise from the walkability grid. */
+static inline unsigned int dStarLiteNeighbors(const DStarLite *ds, const Map *map, int pos){
+	return (map->mask != NULL ? map->mask[pos] : mapWalkMask(map, pos / map->cols, pos % map->cols)) & ds->neighborMask;
+}
+
+/* Return the value of "rhs" of the cell "pos", computed from the values of "g" of its neighbors. */
+static double dStarLiteLookahead(const DStarLite *ds, const Map *map, int pos){
+	if (pos == ds->goal)
+		return 0.0;
+	if (!mapIsFree(map, pos / map->cols, pos % map->cols))
+		return INFINITY;
+	double rhs = INFINITY;
+	for (unsigned int mask = dStarLiteNeighbors(ds, map, pos); mask != 0; mask &= mask - 1) {
+		int bit = __builtin_ctz(mask);
+		double cost = mapNeighborCost[bit] + ds->g[pos + ds->offset[bit]];
+		if (cost < rhs)
+			rhs = cost;
+	}
+	return rhs;
+}
+
+/* Put the cell "pos" in the heap with its current key if it is inconsistent, or remove it from the heap if it is consistent. It
+is returned false in case of failed allocation. */
+static bool dStarLiteQueue(DStarLite *ds, const Map *map, int pos){
+	if (ds->g[pos] == ds->rhs[pos]) {
+		if (ds->handle[pos] >= 0)
+			dStarLiteRemove(ds, pos);
+		return true;
+	}
+	if (ds->handle[pos] < 0) {
+		if (ds->size >= ds->alloc) {
+			DStarNode *heap = (DStarNode *)realloc(ds->heap, 2*ds->alloc*sizeof(DStarNode));
+			if (heap == NULL)
+				return false;
+			ds->heap = heap;
+			ds->alloc *= 2;
+		}
+		ds->handle[pos] = ds->size++;
+	}
+	ds->heap[ds->handle[pos]] = dStarLiteKey(ds, map, pos);
+	dStarLiteSift(ds, ds->handle[pos]);
+	return true;
+}
+
+/* Allocation of the state of D* Lite for the map "map", whose moves are the bits "neighborMask" of the walkability masks. It is
+returned false in case of failed allocation. */
+static bool dStarLiteInit(DStarLite *ds, const Map *map, unsigned int neighborMask){
+	ds->numCells = map->rows*map->cols;
+	ds->neighborMask = neighborMask;
+	ds->size = 0;
+	ds->alloc = 1024;
+	for (int i = 0; i < 8; i++)
+		ds->offset[i] = mapNeighborDelta[i][0]*map->cols + mapNeighborDelta[i][1];
+	ds->g = (double *)malloc((size_t)ds->numCells*sizeof(double));
+	ds->rhs = (double *)malloc((size_t)ds->numCells*sizeof(double));
+	ds->handle = (int *)malloc((size_t)ds->numCells*sizeof(int));
+	ds->heap = (DStarNode *)malloc(ds->alloc*sizeof(DStarNode));
+	if (ds->g == NULL || ds->rhs == NULL || ds->handle == NULL || ds->heap == NULL) {
+		free(ds->g);
+		free(ds->rhs);
+		free(ds->handle);
+		free(ds->heap);
+		return false;
+	}
+	return true;
+}
+
+/* Free the vectors of D* Lite. */
+static void dStarLiteFree(DStarLite *ds){
+	free(ds->g);
+	free(ds->rhs);
+	free(ds->handle);
+	free(ds->heap);
+}
+
+/* Expand the inconsistent cells in order of key until the starting point is consistent and no cell with a lower key is left
+(or an equal one, up to rounding): then the value of "g" of the starting point is its distance from the goal point. A cell whose value of "g" is too high
+(overconsistent) takes the value of "rhs" and lowers the values of "rhs" of its neighbors; a cell whose value of "g" is too low
+(underconsistent, e.g., because the path through it has been blocked) is reset to INFINITY and the values of "rhs" that depended
+on it are recomputed. It is returned false in case of failed allocation. */
+static bool dStarLiteCompute(DStarLite *ds, const Map *map){
+	ds->expanded = 0;
+	while (ds->size > 0) {
+		DStarNode startKey = dStarLiteKey(ds, map, ds->start);
+		if (ds->heap[0].k1 > startKey.k1*(1 + D_STAR_TOLERANCE) && ds->g[ds->start] == ds->rhs[ds->start])
+			break;
+		DStarNode top = ds->heap[0];
+		DStarNode key = dStarLiteKey(ds, map, top.pos);
+		int u = top.pos;
+		if (dStarLiteBefore(&top, &key)) {
+			ds->heap[0] = key;		// The key is out of date: the cell is put back in its place
+			dStarLiteSift(ds, 0);
+			continue;
+		}
+		ds->expanded++;
+		unsigned int mask = mapIsFree(map, u / map->cols, u % map->cols) ? dStarLiteNeighbors(ds, map, u) : 0;
+		if (ds->g[u] > ds->rhs[u]) {
+			ds->g[u] = ds->rhs[u];
+			dStarLiteRemove(ds, u);
+			for (; mask != 0; mask &= mask - 1) {
+				int bit = __builtin_ctz(mask);
+				int s = u + ds->offset[bit];
+				if (s != ds->goal && mapNeighborCost[bit] + ds->g[u] < ds->rhs[s]) {
+					ds->rhs[s] = mapNeighborCost[bit] + ds->g[u];
+					if (!dStarLiteQueue(ds, map, s))
+						return false;
+				}
+			}
+		} else {
+			double oldG = ds->g[u];
+			ds->g[u] = INFINITY;
+			for (; mask != 0; mask &= mask - 1) {
+				int bit = __builtin_ctz(mask);
+				int s = u + ds->offset[bit];
+				if (s != ds->goal && ds->rhs[s] == mapNeighborCost[bit] + oldG) {
+					ds->rhs[s] = dStarLiteLookahead(ds, map, s);
+					if (!dStarLiteQueue(ds, map, s))
+						return false;
+				}
+			}
+			ds->rhs[u] = dStarLiteLookahead(ds, map, u);
+			if (!dStarLiteQueue(ds, map, u))
+				return false;
+		}
+	}
+	return true;
+}
+
+/* First search between "start" and "goal" (positions of the cells): all the cells are reset, which costs as much as the whole
+map, and the distances are computed from scratch. It is returned false in case of failed allocation. */
+static bool dStarLitePlan(DStarLite *ds, const Map *map, int start, int goal){
+	for (int i = 0; i < ds->numCells; i++) {
+		ds->g[i] = INFINITY;
+		ds->rhs[i] = INFINITY;
+		ds->handle[i] = -1;
+	}
+	ds->size = 0;
+	ds->start = start;
+	ds->goal = goal;
+	ds->rhs[goal] = 0.0;
+	return dStarLiteQueue(ds, map, goal) && dStarLiteCompute(ds, map);
+}
+
+/* Repair of the search after the cells "changed" (positions, "numChanged" of them) of the map have become free or occupied
+(the map must already contain the new states, see mapSetCell()): the values of "rhs" of the cells changed and of their neighbors
+are recomputed and the search goes on from the cells that have become inconsistent. It is returned false in case of failed
+allocation. */
+static bool dStarLiteUpdate(DStarLite *ds, const Map *map, const int changed[], int numChanged){
+	for (int i = 0; i < numChanged; i++) {
+		int pos = changed[i];
+		int r = pos / map->cols, c = pos % map->cols;
+		ds->rhs[pos] = dStarLiteLookahead(ds, map, pos);
+		if (!dStarLiteQueue(ds, map, pos))
+			return false;
+		for (int bit = 0; bit < 8; bit++) {
+			int nr = r + mapNeighborDelta[bit][0], nc = c + mapNeighborDelta[bit][1];
+			if (!((ds->neighborMask >> bit) & 1) || nr < 0 || nr >= map->rows || nc < 0 || nc >= map->cols)
+				continue;
+			int s = pos + ds->offset[bit];
+			ds->rhs[s] = dStarLiteLookahead(ds, map, s);
+			if (!dStarLiteQueue(ds, map, s))
+				return false;
+		}
+	}
+	return dStarLiteCompute(ds, map);
+}
+
+/* Path from the goal point to the starting point (the same order of the other searches) in "*path", which has room for
+"*alloc" cells and is reallocated if needed: from the starting point, the move to the neighbor with the lowest cost plus value
+of "g" is taken until the goal point is reached. The length of the path is returned in "*length". It is returned the number of
+cells of the path, 0 if the goal point is not reachable and -1 in case of failed allocation. */
+static int dStarLitePath(const DStarLite *ds, const Map *map, int **path, int *alloc, double *length){
+	if (ds->g[ds->start] == INFINITY)
+		return 0;
+	int pos = ds->start, size = 0;
+	*length = 0.0;
+	while (1) {
+		if (size >= *alloc) {
+			int *grown = (int *)realloc(*path, 2*(*alloc)*sizeof(int));
+			if (grown == NULL)
+				return -1;
+			*path = grown;
+			*alloc *= 2;
+		}
+		(*path)[size++] = pos;
+		if (pos == ds->goal)
+			break;
+		int best = -1;
+		double bestCost = INFINITY;
+		for (unsigned int mask = dStarLiteNeighbors(ds, map, pos); mask != 0; mask &= mask - 1) {
+			int bit = __builtin_ctz(mask);
+			double cost = mapNeighborCost[bit] + ds->g[pos + ds->offset[bit]];
+			if (cost < bestCost) {
+				bestCost = cost;
+				best = bit;
+			}
+		}
+		if (best < 0)
+			return 0;
+		*length += mapNeighborCost[best];
+		pos += ds->offset[best];
+	}
+	for (int i = 0; i < size / 2; i++) {
+		int tmp = (*path)[i];
+		(*path)[i] = (*path)[size-1-i];
+		(*path)[size-1-i] = tmp;
+	}
+	return size;
+}
+
+#endif
@@ -0,0 +1,593 @@
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "open-set.h"
+#include "arena.h"
+#include "map.h"
+
+/* Hierarchical path-finding (HPA*) for repeated queries on the same map. The map is split in square clusters of
+HIERARCHY_CLUSTER x HIERARCHY_CLUSTER cells. Along the border between two adjacent clusters, every maximal run of pairs of
+free cells facing each other is an entrance, crossed by one transition in its middle (or by two, at its ends, if it is at
+least HIERARCHY_WIDE cells long). The two cells of a transition are nodes of the abstract graph, joined by an edge of cost 1;
+the nodes of the same cluster are joined by edges whose cost is the length of the shortest path between them inside the
+cluster.
+A query connects the starting point and the goal point to the nodes of their clusters, searches the abstract graph with A*
+and refines every abstract edge into the cells of the map with a search inside a single cluster. The path found is
+near-optimal: it only crosses the borders of the clusters at the transitions.
+
+The abstract graph is saved in a file next to the map ("<map file>.hpa"), so that it is built only once for every map:
+	HierarchyHeader		"AHPA" magic, version, dimensions of the map, cluster size, number of nodes and edges, checksum of the map
+	nodePos				numNodes 32-bit positions of the cells of the nodes, sorted by cluster and position
+	edgeFirst			numNodes + 1 64-bit offsets: the edges of node n are edgeFirst[n] .. edgeFirst[n+1] - 1
+	edgeTo				numEdges 32-bit target nodes
+	edgeCost			numEdges 64-bit costs */
+
+#define HIERARCHY_MAGIC "AHPA"		// First 4 bytes of an abstraction file
+#define HIERARCHY_VERSION 1			// Version of the abstraction file format
+#define HIERARCHY_CLUSTER 16		// Side of a cluster (cells)
+#define HIERARCHY_WIDE 6			// Minimum length of an entrance crossed by two transitions
+
+typedef struct {
+	char magic[4];				// HIERARCHY_MAGIC
+	uint32_t version;			// HIERARCHY_VERSION
+	int32_t rows, cols;			// Dimensions of the map
+	int32_t cluster;			// Side of a cluster
+	int32_t numNodes;			// Number of nodes of the abstract graph
+	int64_t numEdges;			// Number of edges of the abstract graph
+	uint64_t checksum;			// Checksum of the map (see mapChecksum())
+} HierarchyHeader;
+
+typedef struct {
+	int rows, cols;				// Dimensions of the map
+	int cluster;				// Side of a cluster
+	int clusterRows, clusterCols;	// Number of clusters along the rows and the columns of the map
+	int numNodes;				// Number of nodes of the abstract graph
+	int64_t numEdges;			// Number of edges of the abstract graph
+	int32_t *nodePos;			// Position (row*cols + col) of the cell of every node
+	int32_t *clusterFirst;		// The nodes of cluster k are clusterFirst[k] .. clusterFirst[k+1] - 1
+	int64_t *edgeFirst;			// The edges of node n are edgeFirst[n] .. edgeFirst[n+1] - 1
+	int32_t *edgeTo;			// Target node of every edge
+	double *edgeCost;			// Cost of every edge
+} Hierarchy;
+
+typedef struct {
+	OpenSet openSet;			// Open set of the search, indexed by the position inside the cluster
+	double *g;					// Distance of every cell of the cluster from the source
+	int *parent;				// Position inside the cluster of the parent of every cell
+	unsigned char *closed;		// Cells of the cluster already expanded
+	int r0, c0;					// First row and first column of the cluster last searched
+	int width, height;			// Dimensions of the cluster last searched
+} ClusterSearch;
+
+/* Vector of positions of cells with geometric growth. */
+typedef struct {
+	int *data;
+	size_t size, alloc;
+} HierarchyVector;
+
+/* Edges of the abstract graph while it is built, in the order in which they are found. */
+typedef struct {
+	int32_t *from, *to;			// Nodes joined by every edge
+	double *cost;				// Cost of every edge
+	size_t size, alloc;
+} HierarchyEdges;
+
+/* Append a value to the vector. It is returned false in case of failed allocation. */
+static bool hierarchyVectorAdd(HierarchyVector *v, int value){
+	if (v->size == v->alloc) {
+		size_t alloc = (v->alloc > 0) ? 2*v->alloc : 1024;
+		int *data = (int *)realloc(v->data, alloc*sizeof(int));
+		if (data == NULL)
+			return false;
+		v->data = data;
+		v->alloc = alloc;
+	}
+	v->data[v->size++] = value;
+	return true;
+}
+
+/* Append the edge from "from" to "to" of cost "cost". It is returned false in case of failed allocation. */
+static bool hierarchyEdgeAdd(HierarchyEdges *edges, int from, int to, double cost){
+	if (edges->size == edges->alloc) {
+		size_t alloc = (edges->alloc > 0) ? 2*edges->alloc : 1024;
+		int32_t *newFrom = (int32_t *)realloc(edges->from, alloc*sizeof(int32_t));
+		if (newFrom != NULL)
+			edges->from = newFrom;
+		int32_t *newTo = (int32_t *)realloc(edges->to, alloc*sizeof(int32_t));
+		if (newTo != NULL)
+			edges->to = newTo;
+		double *newCost = (double *)realloc(edges->cost, alloc*sizeof(double));
+		if (newCost != NULL)
+			edges->cost = newCost;
+		if (newFrom == NULL || newTo == NULL || newCost == NULL)
+			return false;
+		edges->alloc = alloc;
+	}
+	edges->from[edges->size] = from;
+	edges->to[edges->size] = to;
+	edges->cost[edges->size++] = cost;
+	return true;
+}
+
+/* Return the cluster of the cell in position "pos". */
+static inline int hierarchyClusterOf(const Hierarchy *h, int pos){
+	return (pos / h->cols / h->cluster)*h->clusterCols + (pos % h->cols) / h->cluster;
+}
+
+/* Return the Euclidean distance between the cells in positions "a" and "b" of a map with "cols" columns. */
+static inline double hierarchyDistance(int cols, int a, int b){
+	double deltaRow = a / cols - b / cols, deltaCol = a % cols - b % cols;		// In double, since the squares may not fit in an int
+	return sqrt(deltaRow*deltaRow + deltaCol*deltaCol);
+}
+
+/* Return the node of the cell in position "pos", or -1 if the cell is not a node. */
+static int hierarchyNode(const Hierarchy *h, int pos){
+	int k = hierarchyClusterOf(h, pos);
+	int low = h->clusterFirst[k], high = h->clusterFirst[k+1] - 1;
+	while (low <= high) {
+		int mid = (low + high) / 2;
+		if (h->nodePos[mid] == pos)
+			return mid;
+		if (h->nodePos[mid] < pos)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
+	return -1;
+}
+
+/* Return the number of bytes taken from an arena by the vectors used by the searches inside a cluster (see clusterSearchInit()). */
+static size_t clusterSearchBytes(int cluster){
+	size_t cells = (size_t)cluster*cluster;
+	return arenaBytes(cells*sizeof(double)) + arenaBytes(cells*sizeof(int)) + arenaBytes(cells) + openSetArenaBytes(cells);
+}
+
+/* Allocation of the vectors used by the searches inside a cluster, taken from the arena "arena" and released with it. It is
+returned false if the arena does not have room for them. */
+static bool clusterSearchInit(ClusterSearch *cs, int cluster, Arena *arena){
+	int cells = cluster*cluster;
+	cs->g = (double *)arenaAlloc(arena, cells*sizeof(double));
+	cs->parent = (int *)arenaAlloc(arena, cells*sizeof(int));
+	cs->closed = (unsigned char *)arenaAlloc(arena, cells*sizeof(unsigned char));
+	return cs->g != NULL && cs->parent != NULL && cs->closed != NULL && openSetInitArena(&cs->openSet, cells, arena);
+}
+
+/* Return the position inside the cluster last searched of the cell in position "pos" of the map. */
+static inline int clusterLocal(const ClusterSearch *cs, int cols, int pos){
+	return (pos / cols - cs->r0)*cs->width + pos % cols - cs->c0;
+}
+
+/* Dijkstra search from the cell in position "source" of the map, moving only inside the cluster "k". The distances of the
+cells of the cluster are left in cs->g (HUGE_VAL for the cells that can not be reached) and their parents in cs->parent, both
+indexed by the position inside the cluster (see clusterLocal()). If "target" is not -1 the search stops as soon as the cell in
+that position of the map is reached. */
+static void clusterSearch(ClusterSearch *cs, const Hierarchy *h, const Map *map, int k, int source, int target){
+	cs->r0 = (k / h->clusterCols)*h->cluster;
+	cs->c0 = (k % h->clusterCols)*h->cluster;
+	cs->height = (map->rows - cs->r0 < h->cluster) ? map->rows - cs->r0 : h->cluster;
+	cs->width = (map->cols - cs->c0 < h->cluster) ? map->cols - cs->c0 : h->cluster;
+	for (int i = 0; i < cs->width*cs->height; i++) {
+		cs->g[i] = HUGE_VAL;
+		cs->closed[i] = 0;
+	}
+
+	int localSource = clusterLocal(cs, map->cols, source);
+	int localTarget = (target >= 0) ? clusterLocal(cs, map->cols, target) : -1;
+	cs->g[localSource] = 0.0;
+	cs->parent[localSource] = localSource;
+	openSetPush(&cs->openSet, localSource, 0.0);		// The heap has room for all the cells of a cluster
+
+	while (cs->openSet.size > 0) {
+		int p = openSetPop(&cs->openSet);
+		cs->closed[p] = 1;
+		if (p == localTarget)
+			break;
+		int row = p / cs->width, col = p % cs->width;
+		for (int deltaRow = -1; deltaRow <= 1; deltaRow++) {
+			for (int deltaCol = -1; deltaCol <= 1; deltaCol++) {
+				int r = row + deltaRow, c = col + deltaCol;
+				if ((deltaRow == 0 && deltaCol == 0) || r < 0 || r >= cs->height || c < 0 || c >= cs->width || !mapIsFree(map, cs->r0 + r, cs->c0 + c))
+					continue;
+				int q = r*cs->width + c;
+				double tmpG = cs->g[p] + ((deltaRow != 0 && deltaCol != 0) ? sqrt(2.0) : 1.0);
+				if (cs->closed[q] || tmpG >= cs->g[q])
+					continue;
+				cs->g[q] = tmpG;
+				cs->parent[q] = p;
+				if (openSetContains(&cs->openSet, q))
+					openSetDecreaseKey(&cs->openSet, q, tmpG);
+				else
+					openSetPush(&cs->openSet, q, tmpG);
+			}
+		}
+	}
+
+	// The open set is emptied, so that it can be used by the next search
+	while (cs->openSet.size > 0)
+		openSetPop(&cs->openSet);
+}
+
+/* Add the transitions of an entrance, i.e., of the pairs of cells a + i*step (first cluster) and b + i*step (second cluster)
+for i = 0..len-1, to the vector "transitions" (as consecutive pairs of positions). It is returned false in case of failed
+allocation. */
+static bool hierarchyEntrance(HierarchyVector *transitions, int a, int b, int step, int len){
+	if (len < HIERARCHY_WIDE)
+		return hierarchyVectorAdd(transitions, a + (len-1)/2*step) && hierarchyVectorAdd(transitions, b + (len-1)/2*step);
+	return hierarchyVectorAdd(transitions, a) && hierarchyVectorAdd(transitions, b)
+		&& hierarchyVectorAdd(transitions, a + (len-1)*step) && hierarchyVectorAdd(transitions, b + (len-1)*step);
+}
+
+/* Scan the border between two adjacent clusters, made of the cells a + i*step (first cluster) and b + i*step (second
+cluster) for i = 0..len-1, and add the transitions of its entrances. It is returned false in case of failed allocation. */
+static bool hierarchyBorder(HierarchyVector *transitions, const Map *map, int a, int b, int step, int len){
+	int first = -1;		// First pair of the current entrance
+	for (int i = 0; i <= len; i++) {
+		int pa = a + i*step, pb = b + i*step;
+		bool open = i < len && mapIsFree(map, pa / map->cols, pa % map->cols) && mapIsFree(map, pb / map->cols, pb % map->cols);
+		if (open && first < 0) {
+			first = i;
+		} else if (!open && first >= 0) {
+			if (!hierarchyEntrance(transitions, a + first*step, b + first*step, step, i - first))
+				return false;
+			first = -1;
+		}
+	}
+	return true;
+}
+
+/* Compare two 64-bit keys (for qsort()). */
+static int hierarchyCompare(const void *a, const void *b){
+	int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+	return (x > y) - (x < y);
+}
+
+/* Fill the first node of every cluster. The nodes must be sorted by cluster. It is returned false in case of failed
+allocation. */
+static bool hierarchyIndex(Hierarchy *h){
+	int clusters = h->clusterRows*h->clusterCols;
+	h->clusterFirst = (int32_t *)calloc(clusters + 1, sizeof(int32_t));
+	if (h->clusterFirst == NULL)
+		return false;
+	for (int n = 0; n < h->numNodes; n++)
+		h->clusterFirst[hierarchyClusterOf(h, h->nodePos[n]) + 1]++;
+	for (int k = 0; k < clusters; k++)
+		h->clusterFirst[k+1] += h->clusterFirst[k];
+	return true;
+}
+
+/* Free the abstract graph. */
+static void hierarchyFree(Hierarchy *h){
+	free(h->nodePos);
+	free(h->clusterFirst);
+	free(h->edgeFirst);
+	free(h->edgeTo);
+	free(h->edgeCost);
+	memset(h, 0, sizeof(*h));
+}
+
+/* Set the dimensions of the abstraction of a map with clusters of "cluster" x "cluster" cells. */
+static void hierarchySetSize(Hierarchy *h, const Map *map, int cluster){
+	memset(h, 0, sizeof(*h));
+	h->rows = map->rows;
+	h->cols = map->cols;
+	h->cluster = cluster;
+	h->clusterRows = (map->rows + cluster - 1) / cluster;
+	h->clusterCols = (map->cols + cluster - 1) / cluster;
+}
+
+/* Build the abstract graph of the map: the transitions are found scanning the borders between the clusters, their cells
+become the nodes and the edges inside every cluster are obtained with a search from each of its nodes. It is returned false
+in case of failed allocation. */
+static bool hierarchyBuild(Hierarchy *h, const Map *map, int cluster){
+	hierarchySetSize(h, map, cluster);
+	int rows = map->rows, cols = map->cols;
+	HierarchyVector transitions = {NULL, 0, 0};
+	bool ok = true;
+
+	// Borders between clusters side by side, then between clusters one above the other
+	for (int x = cluster; ok && x < cols; x += cluster)
+		for (int r0 = 0; ok && r0 < rows; r0 += cluster)
+			ok = hierarchyBorder(&transitions, map, r0*cols + x-1, r0*cols + x, cols, (rows - r0 < cluster) ? rows - r0 : cluster);
+	for (int y = cluster; ok && y < rows; y += cluster)
+		for (int c0 = 0; ok && c0 < cols; c0 += cluster)
+			ok = hierarchyBorder(&transitions, map, (y-1)*cols + c0, y*cols + c0, 1, (cols - c0 < cluster) ? cols - c0 : cluster);
+
+	// Nodes: the cells of the transitions, sorted by cluster and position, without duplicates
+	int64_t *keys = ok ? (int64_t *)malloc((transitions.size + 1)*sizeof(int64_t)) : NULL;
+	if (keys != NULL) {
+		for (size_t i = 0; i < transitions.size; i++)
+			keys[i] = ((int64_t)hierarchyClusterOf(h, transitions.data[i]) << 32) | transitions.data[i];
+		qsort(keys, transitions.size, sizeof(int64_t), hierarchyCompare);
+		h->nodePos = (int32_t *)malloc((transitions.size + 1)*sizeof(int32_t));
+		if (h->nodePos != NULL) {
+			for (size_t i = 0; i < transitions.size; i++)
+				if (i == 0 || keys[i] != keys[i-1])
+					h->nodePos[h->numNodes++] = (int32_t)keys[i];
+		}
+	}
+	free(keys);
+	ok = (h->nodePos != NULL) && hierarchyIndex(h);
+
+	// Edges, in the order in which they are found, then grouped by node: first the transitions, then the shortest paths
+	// between the nodes of every cluster
+	HierarchyEdges edges = {NULL, NULL, NULL, 0, 0};
+	ClusterSearch cs;
+	Arena arena = {NULL, 0, 0};
+	ok = ok && arenaInit(&arena, clusterSearchBytes(cluster)) && clusterSearchInit(&cs, cluster, &arena);
+	if (ok) {
+		for (size_t i = 0; ok && i < transitions.size; i += 2) {
+			int a = hierarchyNode(h, transitions.data[i]), b = hierarchyNode(h, transitions.data[i+1]);
+			ok = hierarchyEdgeAdd(&edges, a, b, 1.0) && hierarchyEdgeAdd(&edges, b, a, 1.0);
+		}
+		for (int k = 0; ok && k < h->clusterRows*h->clusterCols; k++) {
+			for (int n = h->clusterFirst[k]; ok && n < h->clusterFirst[k+1]; n++) {
+				clusterSearch(&cs, h, map, k, h->nodePos[n], -1);
+				for (int m = h->clusterFirst[k]; ok && m < h->clusterFirst[k+1]; m++) {
+					double g = cs.g[clusterLocal(&cs, cols, h->nodePos[m])];
+					if (m != n && g != HUGE_VAL)
+						ok = hierarchyEdgeAdd(&edges, n, m, g);
+				}
+			}
+		}
+	}
+	arenaFree(&arena);
+
+	if (ok) {
+		h->numEdges = (int64_t)edges.size;
+		h->edgeFirst = (int64_t *)calloc(h->numNodes + 1, sizeof(int64_t));
+		h->edgeTo = (int32_t *)malloc((edges.size + 1)*sizeof(int32_t));
+		h->edgeCost = (double *)malloc((edges.size + 1)*sizeof(double));
+		ok = h->edgeFirst != NULL && h->edgeTo != NULL && h->edgeCost != NULL;
+	}
+	if (ok) {
+		for (size_t e = 0; e < edges.size; e++)
+			h->edgeFirst[edges.from[e] + 1]++;
+		for (int n = 0; n < h->numNodes; n++)
+			h->edgeFirst[n+1] += h->edgeFirst[n];
+		for (size_t e = 0; e < edges.size; e++) {
+			int64_t i = h->edgeFirst[edges.from[e]]++;
+			h->edgeTo[i] = edges.to[e];
+			h->edgeCost[i] = edges.cost[e];
+		}
+		for (int n = h->numNodes; n > 0; n--)		// The offsets have been moved forward by the filling
+			h->edgeFirst[n] = h->edgeFirst[n-1];
+		h->edgeFirst[0] = 0;
+	}
+
+	free(transitions.data);
+	free(edges.from);
+	free(edges.to);
+	free(edges.cost);
+	if (!ok)
+		hierarchyFree(h);
+	return ok;
+}
+/* Write the abstract graph of the map in the file "fname". It is returned false in case of error. */
+static bool hierarchySave(const Hierarchy *h, const Map *map, const char *fname){
+	HierarchyHeader header;
+	memcpy(header.magic, HIERARCHY_MAGIC, 4);
+	header.version = HIERARCHY_VERSION;
+	header.rows = h->rows;
+	header.cols = h->cols;
+	header.cluster = h->cluster;
+	header.numNodes = h->numNodes;
+	header.numEdges = h->numEdges;
+	header.checksum = mapChecksum(map);
+
+	FILE *fp = fopen(fname, "wb");
+	if (fp == NULL)
+		return false;
+	size_t nodes = h->numNodes, edges = h->numEdges;
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+		&& fwrite(h->nodePos, sizeof(int32_t), nodes, fp) == nodes
+		&& fwrite(h->edgeFirst, sizeof(int64_t), nodes + 1, fp) == nodes + 1
+		&& fwrite(h->edgeTo, sizeof(int32_t), edges, fp) == edges
+		&& fwrite(h->edgeCost, sizeof(double), edges, fp) == edges;
+	return (fclose(fp) == 0) && ok;
+}
+
+/* Read the abstract graph of the map from the file "fname". It is returned false if the file can not be read or if it does
+not belong to the map (different dimensions, cluster size or checksum of the cells), in which case it has to be built
+again. */
+static bool hierarchyLoad(Hierarchy *h, const Map *map, const char *fname){
+	FILE *fp = fopen(fname, "rb");
+	if (fp == NULL)
+		return false;
+
+	HierarchyHeader header;
+	bool ok = fread(&header, sizeof(header), 1, fp) == 1 && memcmp(header.magic, HIERARCHY_MAGIC, 4) == 0
+		&& header.version == HIERARCHY_VERSION && header.rows == map->rows && header.cols == map->cols
+		&& header.cluster == HIERARCHY_CLUSTER && header.numNodes >= 0 && header.numEdges >= 0
+		&& header.checksum == mapChecksum(map);
+	if (ok) {
+		hierarchySetSize(h, map, header.cluster);
+		h->numNodes = header.numNodes;
+		h->numEdges = header.numEdges;
+		size_t nodes = h->numNodes, edges = h->numEdges;
+		h->nodePos = (int32_t *)malloc((nodes + 1)*sizeof(int32_t));
+		h->edgeFirst = (int64_t *)malloc((nodes + 1)*sizeof(int64_t));
+		h->edgeTo = (int32_t *)malloc((edges + 1)*sizeof(int32_t));
+		h->edgeCost = (double *)malloc((edges + 1)*sizeof(double));
+		ok = h->nodePos != NULL && h->edgeFirst != NULL && h->edgeTo != NULL && h->edgeCost != NULL
+			&& fread(h->nodePos, sizeof(int32_t), nodes, fp) == nodes
+			&& fread(h->edgeFirst, sizeof(int64_t), nodes + 1, fp) == nodes + 1
+			&& fread(h->edgeTo, sizeof(int32_t), edges, fp) == edges
+			&& fread(h->edgeCost, sizeof(double), edges, fp) == edges
+			&& fgetc(fp) == EOF && h->edgeFirst[nodes] == h->numEdges && hierarchyIndex(h);
+		if (!ok)
+			hierarchyFree(h);
+	}
+	fclose(fp);
+	return ok;
+}
+
+/* Obtain the abstract graph of the map read from the file "mapName": it is read from "<mapName>.hpa" if this file belongs to
+the map, otherwise it is built and saved there. In case of an error an error message is shown and it is returned false. */
+static bool hierarchyPrepare(Hierarchy *h, const Map *map, const char *mapName){
+	char fname[FILENAME_MAX];
+	snprintf(fname, sizeof(fname), "%s.hpa", mapName);
+
+	printf("Reading the abstraction of the map... ");
+	if (hierarchyLoad(h, map, fname)) {
+		printf("Abstract graph with %d nodes and %lld edges read from %s.\n", h->numNodes, (long long)h->numEdges, fname);
+		return true;
+	}
+	printf("Not present or not up to date.\nBuilding the abstraction of the map... ");
+	if (!hierarchyBuild(h, map, HIERARCHY_CLUSTER)) {
+		printf("\nFailed allocation.\n");
+		return false;
+	}
+	printf("Abstract graph with %d nodes and %lld edges built.\n", h->numNodes, (long long)h->numEdges);
+	if (hierarchySave(h, map, fname))
+		printf("Abstraction saved in %s.\n", fname);
+	else
+		printf("Warning: the abstraction could not be saved in %s.\n", fname);
+	return true;
+}
+
+/* Relaxation of the abstract edge from "node" to "next" of cost "cost": "next" gets a new parent if it is reached with a lower
+cost than before. "heuristic" is the estimated distance between "next" and the goal point. It is returned false in case of
+failed allocation. */
+static bool hierarchyRelax(OpenSet *os, double g[], int parent[], const unsigned char closed[], int node, int next, double cost, double heuristic){
+	double tmpG = g[node] + cost;
+	if (closed[next] || tmpG >= g[next])
+		return true;
+	g[next] = tmpG;
+	parent[next] = node;
+	if (openSetContains(os, next)) {
+		openSetDecreaseKey(os, next, tmpG + heuristic);
+		return true;
+	}
+	return openSetPush(os, next, tmpG + heuristic);
+}
+
+/* Return the number of bytes of the arena used by hierarchySearch() on the abstract graph "h" (the same for all its queries). */
+static size_t hierarchySearchBytes(const Hierarchy *h){
+	size_t nodes = (size_t)h->numNodes + 2;
+	size_t clusterNodes = 0;		// Highest number of nodes of a cluster
+	for (int k = 0; k < h->clusterRows*h->clusterCols; k++)
+		if ((size_t)(h->clusterFirst[k+1] - h->clusterFirst[k]) > clusterNodes)
+			clusterNodes = h->clusterFirst[k+1] - h->clusterFirst[k];
+	return 2*arenaBytes((clusterNodes + 1)*sizeof(double)) + arenaBytes(nodes*sizeof(double)) + 2*arenaBytes(nodes*sizeof(int))
+		+ arenaBytes(nodes) + openSetArenaBytes(nodes) + clusterSearchBytes(h->cluster);
+}
+
+/* Search of a path between the cells in positions "start" and "goal" of the map, using its abstract graph. All the vectors of
+the search are taken from the arena "arena", which has to be at least hierarchySearchBytes() bytes long and is emptied first,
+so that an arena can be reused by all the queries on the same map. The path is returned in "*path" (allocated with malloc, from
+the goal point to the starting point, as in the A* search), with its number of cells in "*pathSize" and its length in
+"*length". It is returned 1 if a path has been found, 0 if the abstract graph does not connect the two points and -1 in case of
+failed allocation. */
+static int hierarchySearch(const Hierarchy *h, const Map *map, Arena *arena, int start, int goal, int **path, int *pathSize, double *length){
+	int numNodes = h->numNodes;
+	int nodeS = numNodes, nodeG = numNodes + 1;		// The starting point and the goal point are added to the graph
+	int clusterS = hierarchyClusterOf(h, start), clusterG = hierarchyClusterOf(h, goal);
+	int firstS = h->clusterFirst[clusterS], numS = h->clusterFirst[clusterS+1] - firstS;
+	int firstG = h->clusterFirst[clusterG], numG = h->clusterFirst[clusterG+1] - firstG;
+
+	ClusterSearch cs;
+	OpenSet os;
+	arenaReset(arena);
+	double *costS = (double *)arenaAlloc(arena, (numS + 1)*sizeof(double));		// Costs from the starting point to the nodes of its cluster
+	double *costG = (double *)arenaAlloc(arena, (numG + 1)*sizeof(double));		// Costs from the nodes of the cluster of the goal point to it
+	double *g = (double *)arenaAlloc(arena, (numNodes + 2)*sizeof(double));
+	int *parent = (int *)arenaAlloc(arena, (numNodes + 2)*sizeof(int));
+	unsigned char *closed = (unsigned char *)arenaAlloc(arena, (numNodes + 2)*sizeof(unsigned char));
+	int *abstractPath = (int *)arenaAlloc(arena, (numNodes + 2)*sizeof(int));
+	bool ok = costS != NULL && costG != NULL && g != NULL && parent != NULL && closed != NULL && abstractPath != NULL
+		&& clusterSearchInit(&cs, h->cluster, arena) && openSetInitArena(&os, numNodes + 2, arena);
+	int found = ok ? 0 : -1;
+	*path = NULL;
+
+	if (ok) {
+		// Insertion of the starting point and of the goal point: the edges to the nodes of their clusters
+		double costSG = HUGE_VAL;
+		clusterSearch(&cs, h, map, clusterS, start, -1);
+		for (int i = 0; i < numS; i++)
+			costS[i] = cs.g[clusterLocal(&cs, map->cols, h->nodePos[firstS + i])];
+		if (clusterS == clusterG)
+			costSG = cs.g[clusterLocal(&cs, map->cols, goal)];
+		clusterSearch(&cs, h, map, clusterG, goal, -1);
+		for (int i = 0; i < numG; i++)
+			costG[i] = cs.g[clusterLocal(&cs, map->cols, h->nodePos[firstG + i])];
+
+		// A* search on the abstract graph
+		memset(closed, 0, (numNodes + 2)*sizeof(unsigned char));
+		for (int n = 0; n < numNodes + 2; n++)
+			g[n] = HUGE_VAL;
+		g[nodeS] = 0.0;
+		parent[nodeS] = nodeS;
+		ok = openSetPush(&os, nodeS, hierarchyDistance(map->cols, start, goal));
+		while (ok && os.size > 0) {
+			int node = openSetPop(&os);
+			if (node == nodeG) {
+				found = 1;
+				break;
+			}
+			closed[node] = 1;
+			if (node == nodeS) {
+				for (int i = 0; ok && i < numS; i++)
+					if (costS[i] != HUGE_VAL)
+						ok = hierarchyRelax(&os, g, parent, closed, node, firstS + i, costS[i], hierarchyDistance(map->cols, h->nodePos[firstS + i], goal));
+				if (ok && costSG != HUGE_VAL)
+					ok = hierarchyRelax(&os, g, parent, closed, node, nodeG, costSG, 0.0);
+				continue;
+			}
+			for (int64_t e = h->edgeFirst[node]; ok && e < h->edgeFirst[node+1]; e++)
+				ok = hierarchyRelax(&os, g, parent, closed, node, h->edgeTo[e], h->edgeCost[e], hierarchyDistance(map->cols, h->nodePos[h->edgeTo[e]], goal));
+			if (ok && node >= firstG && node < firstG + numG && costG[node - firstG] != HUGE_VAL)
+				ok = hierarchyRelax(&os, g, parent, closed, node, nodeG, costG[node - firstG], 0.0);
+		}
+		if (!ok)
+			found = -1;
+	}
+
+	if (found == 1) {
+		// Abstract path, from the goal point to the starting point, as positions of the map
+		int numAbstract = 0;
+		for (int node = nodeG; ; node = parent[node]) {
+			abstractPath[numAbstract++] = (node == nodeG) ? goal : (node == nodeS) ? start : h->nodePos[node];
+			if (node == nodeS)
+				break;
+		}
+
+		// Refinement: every abstract edge inside a cluster is replaced by the cells of the shortest path inside the cluster
+		HierarchyVector cells = {NULL, 0, 0};
+		ok = hierarchyVectorAdd(&cells, goal);
+		for (int i = 0; ok && i + 1 < numAbstract; i++) {
+			int b = abstractPath[i], a = abstractPath[i+1];		// The path is built backward, from "b" to "a"
+			int k = hierarchyClusterOf(h, a);
+			if (a == b) {
+				continue;
+			} else if (k != hierarchyClusterOf(h, b)) {
+				ok = hierarchyVectorAdd(&cells, a);				// Transition: "a" and "b" are neighbors
+			} else {
+				clusterSearch(&cs, h, map, k, a, b);
+				int localA = clusterLocal(&cs, map->cols, a);
+				for (int q = clusterLocal(&cs, map->cols, b); ok && q != localA; ) {
+					q = cs.parent[q];
+					ok = hierarchyVectorAdd(&cells, (cs.r0 + q / cs.width)*map->cols + cs.c0 + q % cs.width);
+				}
+			}
+		}
+		if (ok) {
+			*path = cells.data;
+			*pathSize = (int)cells.size;
+			*length = g[nodeG];
+		} else {
+			free(cells.data);
+			found = -1;
+		}
+	}
+
+	return found;
+}
+
+#endif
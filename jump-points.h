@@ -0,0 +1,185 @@
+#ifndef JUMP_POINTS_H
+#define JUMP_POINTS_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "map.h"
+
+/* Jump Point Search (JPS+) on the 8-connected grid of the map. Moving from a cell to a neighbor costs 1 (straight) or
+sqrt(2) (diagonal) and a diagonal move is allowed whenever the neighbor is free, as in the plain A* search. The search only
+expands the jump points, i.e., the cells where an optimal path may have to change direction: a cell reached moving along a
+direction is a jump point if it has a forced neighbor (a neighbor that can not be reached optimally without passing through
+the cell, because of an obstacle next to it) or, for a diagonal direction, if a straight jump along one of the two
+components of the direction starting from it finds a jump point.
+
+For every cell and every direction the distance to the next jump point is precomputed once for the map (JPS+), so that a
+jump costs a single lookup instead of a walk over the cells:
+	d > 0		the jump point is "d" moves away
+	d <= 0		there is no jump point in that direction: the cell is followed by -d free cells and then by an obstacle (or
+				by the border of the map)
+The goal point is handled during the search, since it does not depend on the map. */
+
+#define JUMP_DIRECTIONS 8
+
+// Directions, clockwise from north (row 0 is north, the last column is east): N, NE, E, SE, S, SW, W, NW
+static const int jumpDeltaRow[JUMP_DIRECTIONS] = {-1, -1, 0, 1, 1, 1, 0, -1};
+static const int jumpDeltaCol[JUMP_DIRECTIONS] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+typedef struct {
+	int32_t *dist;				// Distance to the next jump point of the cell in position "pos" along the direction "d", in dist[d*cells + pos]
+	size_t cells;				// Number of cells of the map
+} JumpTable;
+
+/* Obtain the index of the direction (deltaRow, deltaCol), with deltaRow and deltaCol in {-1, 0, 1} but not both 0. */
+static inline int jumpDirection(int deltaRow, int deltaCol){
+	static const int index[3][3] = {{7, 0, 1}, {6, -1, 2}, {5, 4, 3}};
+	return index[deltaRow+1][deltaCol+1];
+}
+
+/* Check if a cell is out of the map or an obstacle. If it is, it is returned true, otherwise false. */
+static inline bool jumpBlocked(const Map *map, int row, int col){
+	return row < 0 || row >= map->rows || col < 0 || col >= map->cols || !mapIsFree(map, row, col);
+}
+
+/* Check if the cell in position "pos" of "open[]" (the map with a border of obstacles, "stride" cells wide, one byte per cell
+set if the cell is free), reached moving along (dr, dc), has a forced neighbor. */
+static inline bool jumpForced(const unsigned char *open, size_t pos, int stride, int dr, int dc){
+	if (dr == 0)
+		return (!open[pos-stride] && open[pos-stride+dc]) || (!open[pos+stride] && open[pos+stride+dc]);
+	if (dc == 0)
+		return (!open[pos-1] && open[pos+dr*stride-1]) || (!open[pos+1] && open[pos+dr*stride+1]);
+	return (!open[pos-dc] && open[pos+dr*stride-dc]) || (!open[pos-dr*stride] && open[pos-dr*stride+dc]);
+}
+
+/* Precomputation of the jump distances of every cell of the map. The straight directions (even indices) are computed before
+the diagonal ones, which depend on them; along a direction the cells are visited starting from the far end of the map, so
+that the distance of a cell is obtained from the one of the next cell. The map is first copied in a grid of bytes with a
+border of obstacles, so that the neighbors of a cell can be read without checking the border. It is returned false in case
+of failed allocation. */
+static bool jumpTableBuild(JumpTable *jt, const Map *map){
+	int rows = map->rows, cols = map->cols;
+	int stride = cols + 2;
+	jt->cells = (size_t)rows*cols;
+	jt->dist = (int32_t *)malloc(jt->cells*JUMP_DIRECTIONS*sizeof(int32_t));
+	unsigned char *open = (unsigned char *)calloc((size_t)(rows+2)*stride, sizeof(unsigned char));
+	if (jt->dist == NULL || open == NULL) {
+		free(jt->dist);
+		free(open);
+		jt->dist = NULL;
+		return false;
+	}
+	for (int r = 0; r < rows; r++)
+		for (int c = 0; c < cols; c++)
+			open[(size_t)(r+1)*stride + c+1] = mapIsFree(map, r, c);
+
+	for (int pass = 0; pass < 2; pass++) {
+		for (int d = pass; d < JUMP_DIRECTIONS; d += 2) {
+			int dr = jumpDeltaRow[d], dc = jumpDeltaCol[d];
+			int32_t *dist = jt->dist + d*jt->cells;
+			const int32_t *distRow = (pass == 1) ? jt->dist + jumpDirection(dr, 0)*jt->cells : dist;	// Straight components of a diagonal
+			const int32_t *distCol = (pass == 1) ? jt->dist + jumpDirection(0, dc)*jt->cells : dist;
+			for (int i = 0; i < rows; i++) {
+				int r = (dr > 0) ? rows-1-i : i;
+				for (int j = 0; j < cols; j++) {
+					int c = (dc > 0) ? cols-1-j : j;
+					size_t next = (size_t)(r+1+dr)*stride + c+1+dc;		// Next cell along the direction, in the padded grid
+					size_t posNext = (size_t)(r+dr)*cols + c+dc;			// Next cell along the direction, in the map
+					int32_t value;
+					if (!open[next])
+						value = 0;
+					else if (jumpForced(open, next, stride, dr, dc) || (pass == 1 && (distRow[posNext] > 0 || distCol[posNext] > 0)))
+						value = 1;
+					else
+						value = (dist[posNext] > 0) ? dist[posNext] + 1 : dist[posNext] - 1;
+					dist[(size_t)r*cols + c] = value;
+				}
+			}
+		}
+	}
+	free(open);
+	return true;
+}
+
+/* Free the jump distances. */
+static void jumpTableFree(JumpTable *jt){
+	free(jt->dist);
+	jt->dist = NULL;
+}
+
+/* Successors of the cell (row, col) reached moving along the direction "arrival" (-1 for the starting point, which has all the
+directions). Only the natural directions (the arrival one and, for a diagonal, its two components) and the ones of the forced
+neighbors are followed. For every successor its position and the cost to reach it are stored in "succ[]" and "cost[]" (at
+most 8 entries) and the number of successors is returned. If the goal point lies along a direction before the next jump point,
+the goal point itself (or, for a diagonal, the cell of the diagonal in the same row or column of the goal point) is the
+successor. */
+static int jumpSuccessors(const JumpTable *jt, const Map *map, int row, int col, int arrival, int goalRow, int goalCol, int succ[], double cost[]){
+	int dirs[JUMP_DIRECTIONS];
+	int numDirs = 0;
+	if (arrival < 0) {
+		for (int d = 0; d < JUMP_DIRECTIONS; d++)
+			dirs[numDirs++] = d;
+	} else {
+		int dr = jumpDeltaRow[arrival], dc = jumpDeltaCol[arrival];
+		dirs[numDirs++] = arrival;
+		if (dr == 0) {
+			if (jumpBlocked(map, row-1, col))
+				dirs[numDirs++] = jumpDirection(-1, dc);
+			if (jumpBlocked(map, row+1, col))
+				dirs[numDirs++] = jumpDirection(1, dc);
+		} else if (dc == 0) {
+			if (jumpBlocked(map, row, col-1))
+				dirs[numDirs++] = jumpDirection(dr, -1);
+			if (jumpBlocked(map, row, col+1))
+				dirs[numDirs++] = jumpDirection(dr, 1);
+		} else {
+			dirs[numDirs++] = jumpDirection(dr, 0);
+			dirs[numDirs++] = jumpDirection(0, dc);
+			if (jumpBlocked(map, row, col-dc))
+				dirs[numDirs++] = jumpDirection(dr, -dc);
+			if (jumpBlocked(map, row-dr, col))
+				dirs[numDirs++] = jumpDirection(-dr, dc);
+		}
+	}
+
+	size_t pos = (size_t)row*map->cols + col;
+	int toRow = goalRow - row, toCol = goalCol - col;
+	int numSucc = 0;
+	for (int i = 0; i < numDirs; i++) {
+		int d = dirs[i];
+		int dr = jumpDeltaRow[d], dc = jumpDeltaCol[d];
+		int32_t dist = jt->dist[d*jt->cells + pos];
+		int reach = (dist > 0) ? dist : -dist;		// Number of moves that can be done along the direction
+		int steps = 0;
+		if (dr == 0 || dc == 0) {
+			// Straight direction: the goal point is a successor if it is in the same row (column) within reach
+			int along = (dr == 0) ? toCol*dc : toRow*dr;
+			int across = (dr == 0) ? toRow : toCol;
+			if (across == 0 && along > 0 && along <= reach)
+				steps = along;
+			else if (dist > 0)
+				steps = dist;
+			if (steps > 0) {
+				succ[numSucc] = (row + steps*dr)*map->cols + col + steps*dc;
+				cost[numSucc++] = steps;
+			}
+		} else {
+			// Diagonal direction: if the goal point is in the quadrant, the diagonal is stopped in its row or column
+			int alongRow = toRow*dr, alongCol = toCol*dc;
+			int closer = (alongRow < alongCol) ? alongRow : alongCol;
+			if (alongRow > 0 && alongCol > 0 && closer <= reach)
+				steps = closer;
+			else if (dist > 0)
+				steps = dist;
+			if (steps > 0) {
+				succ[numSucc] = (row + steps*dr)*map->cols + col + steps*dc;
+				cost[numSucc++] = steps*sqrt(2.0);
+			}
+		}
+	}
+	return numSucc;
+}
+
+#endif
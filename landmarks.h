@@ -0,0 +1,265 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "open-set.h"
+#include "map.h"
+
+/* Landmark heuristic (ALT: A*, landmarks and triangle inequality) for repeated queries on the same map. K landmark cells are
+chosen and the distance between every cell of the map and every landmark is computed with a Dijkstra search. For any landmark
+L the triangle inequality gives |d(L, goal) - d(L, n)| <= d(n, goal), so the maximum of these bounds (and of the Euclidean
+distance) is an admissible and consistent heuristic that, unlike the Euclidean distance alone, knows about the detours forced
+by the obstacles.
+The landmarks are chosen one at a time as far as possible from the ones already chosen (the first one as far as possible from
+the free cell nearest to the center of the map), so that they end up on the borders and in the corners of the map, behind the
+obstacles.
+
+The distances are saved in a file next to the map ("<map file>.alt"), so that they are computed only once for every map:
+	LandmarkHeader		"AALT" magic, version, dimensions of the map, number of landmarks, longest distance, checksum of the map
+	landmarkPos			numLandmarks 32-bit positions of the landmarks
+	distance			rows*cols*numLandmarks 32-bit floats, the distances of a cell from all the landmarks one after the other
+						(INFINITY for the cells that can not be reached from a landmark)
+The distances are stored as floats to halve the memory, and the bounds are scaled down by a relative amount larger than the
+rounding error (see landmarkScale()), so that the heuristic stays consistent. */
+
+#define LANDMARK_MAGIC "AALT"		// First 4 bytes of a landmark file
+#define LANDMARK_VERSION 1			// Version of the landmark file format
+#define LANDMARK_MAX 32				// Maximum number of landmarks
+
+typedef struct {
+	char magic[4];				// LANDMARK_MAGIC
+	uint32_t version;			// LANDMARK_VERSION
+	int32_t rows, cols;			// Dimensions of the map
+	int32_t numLandmarks;		// Number of landmarks
+	double maxDistance;			// Longest finite distance of the tables
+	uint64_t checksum;			// Checksum of the map (see mapChecksum())
+} LandmarkHeader;
+
+typedef struct {
+	int numLandmarks;			// Number of landmarks (0 if the landmark heuristic is not used)
+	int32_t *landmarkPos;		// Position (row*cols + col) of every landmark
+	float *distance;			// Distance of the cell "pos" from the landmark "l" in position pos*numLandmarks + l
+	double maxDistance;			// Longest finite distance of the tables
+	double scale;				// Factor applied to the bounds (see landmarkScale())
+} Landmarks;
+
+/* Return the factor that makes the bounds consistent in spite of the rounding of the distances to floats: every stored distance
+is off by at most maxDistance*2^-24, so a bound is off by at most maxDistance*2^-23, which is covered by lowering it by the
+relative amount maxDistance*2^-22 since every move costs at least 1. */
+static inline double landmarkScale(double maxDistance){
+	return 1.0 - maxDistance*ldexp(1.0, -22);
+}
+
+/* Return the memory used by the distance tables (bytes). */
+static inline size_t landmarkTableSize(const Landmarks *lm, const Map *map){
+	return (size_t)map->rows*map->cols*lm->numLandmarks*sizeof(float);
+}
+
+/* Copy the distances of the cell in position "pos" from the landmarks in "target", the point towards which a search is
+directed. */
+static inline void landmarkTarget(const Landmarks *lm, int pos, float target[]){
+	memcpy(target, lm->distance + (size_t)pos*lm->numLandmarks, lm->numLandmarks*sizeof(float));
+}
+
+/* Return the lower bound of the distance between the cell in position "pos" and the point whose distances from the landmarks are
+"target" (see landmarkTarget()). The landmarks that can not reach one of the two cells give no bound. */
+static inline double landmarkBound(const Landmarks *lm, const float target[], int pos){
+	const float *d = lm->distance + (size_t)pos*lm->numLandmarks;
+	float bound = 0.0f;
+	for (int l = 0; l < lm->numLandmarks; l++) {
+		float diff = fabsf(target[l] - d[l]);
+		if (diff > bound && isfinite(diff))
+			bound = diff;
+	}
+	return bound*lm->scale;
+}
+
+/* Dijkstra search of the whole map from the cell in position "source": the distances are left in g[] (INFINITY for the cells
+that can not be reached). The open set must be empty. */
+static bool landmarkDijkstra(const Map *map, OpenSet *os, double g[], int source){
+	int numCells = map->rows*map->cols;
+	for (int i = 0; i < numCells; i++)
+		g[i] = INFINITY;
+	g[source] = 0.0;
+	if (!openSetPush(os, source, 0.0))
+		return false;
+
+	while (os->size > 0) {
+		int p = openSetPop(os);
+		int row = p / map->cols, col = p % map->cols;
+		for (int deltaRow = -1; deltaRow <= 1; deltaRow++) {
+			for (int deltaCol = -1; deltaCol <= 1; deltaCol++) {
+				int r = row + deltaRow, c = col + deltaCol;
+				if ((deltaRow == 0 && deltaCol == 0) || r < 0 || r >= map->rows || c < 0 || c >= map->cols || !mapIsFree(map, r, c))
+					continue;
+				int q = r*map->cols + c;
+				double tmpG = g[p] + ((deltaRow != 0 && deltaCol != 0) ? sqrt(2.0) : 1.0);
+				if (tmpG >= g[q])
+					continue;
+				if (openSetContains(os, q)) {
+					g[q] = tmpG;
+					openSetDecreaseKey(os, q, tmpG);
+				} else {
+					g[q] = tmpG;
+					if (!openSetPush(os, q, tmpG))
+						return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+/* Free the distance tables. */
+static void landmarksFree(Landmarks *lm){
+	free(lm->landmarkPos);
+	free(lm->distance);
+	lm->landmarkPos = NULL;
+	lm->distance = NULL;
+	lm->numLandmarks = 0;
+}
+
+/* Choose "numLandmarks" landmarks on the map and compute their distance tables. It is returned false in case of failed
+allocation or if the map has no free cell. */
+static bool landmarksBuild(Landmarks *lm, const Map *map, int numLandmarks){
+	int numCells = map->rows*map->cols;
+	lm->numLandmarks = numLandmarks;
+	lm->maxDistance = 0.0;
+	lm->landmarkPos = (int32_t *)malloc(numLandmarks*sizeof(int32_t));
+	lm->distance = (float *)malloc((size_t)numCells*numLandmarks*sizeof(float));
+	double *g = (double *)malloc(numCells*sizeof(double));
+	double *nearest = (double *)malloc(numCells*sizeof(double));		// Distance of every cell from the nearest landmark
+	OpenSet os;
+	bool openSetOk = openSetInit(&os, numCells, 1024);
+	bool ok = lm->landmarkPos != NULL && lm->distance != NULL && g != NULL && nearest != NULL && openSetOk;
+
+	// The search of the first landmark starts from the free cell nearest to the center of the map
+	int source = -1;
+	double best = INFINITY;
+	for (int r = 0; ok && r < map->rows; r++) {
+		for (int c = 0; c < map->cols; c++) {
+			double d = hypot(r - map->rows / 2, c - map->cols / 2);
+			if (mapIsFree(map, r, c) && d < best) {
+				best = d;
+				source = r*map->cols + c;
+			}
+		}
+	}
+	ok = ok && source >= 0 && landmarkDijkstra(map, &os, nearest, source);
+
+	for (int l = 0; ok && l < numLandmarks; l++) {
+		// The next landmark is the reachable cell farthest from the landmarks already chosen
+		int farthest = source;
+		for (int i = 0; i < numCells; i++) {
+			if (isfinite(nearest[i]) && nearest[i] > nearest[farthest])
+				farthest = i;
+		}
+		lm->landmarkPos[l] = farthest;
+		ok = landmarkDijkstra(map, &os, g, farthest);
+		for (int i = 0; ok && i < numCells; i++) {
+			lm->distance[(size_t)i*numLandmarks + l] = (float)g[i];
+			if (isfinite(g[i]) && g[i] > lm->maxDistance)
+				lm->maxDistance = g[i];
+			if (l == 0 || g[i] < nearest[i])
+				nearest[i] = g[i];
+		}
+	}
+	lm->scale = landmarkScale(lm->maxDistance);
+
+	free(g);
+	free(nearest);
+	if (openSetOk)
+		openSetFree(&os);
+	if (!ok)
+		landmarksFree(lm);
+	return ok;
+}
+
+/* Write the distance tables of the map in the file "fname". It is returned false in case of error. */
+static bool landmarksSave(const Landmarks *lm, const Map *map, const char *fname){
+	LandmarkHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, LANDMARK_MAGIC, 4);
+	header.version = LANDMARK_VERSION;
+	header.rows = map->rows;
+	header.cols = map->cols;
+	header.numLandmarks = lm->numLandmarks;
+	header.maxDistance = lm->maxDistance;
+	header.checksum = mapChecksum(map);
+
+	FILE *fp = fopen(fname, "wb");
+	if (fp == NULL)
+		return false;
+	size_t values = (size_t)map->rows*map->cols*lm->numLandmarks;
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1
+		&& fwrite(lm->landmarkPos, sizeof(int32_t), lm->numLandmarks, fp) == (size_t)lm->numLandmarks
+		&& fwrite(lm->distance, sizeof(float), values, fp) == values;
+	return (fclose(fp) == 0) && ok;
+}
+
+/* Read the distance tables of the map from the file "fname". It is returned false if the file can not be read or if it does not
+belong to the map (different dimensions, number of landmarks or checksum of the cells), in which case they have to be computed
+again. */
+static bool landmarksLoad(Landmarks *lm, const Map *map, int numLandmarks, const char *fname){
+	FILE *fp = fopen(fname, "rb");
+	if (fp == NULL)
+		return false;
+
+	LandmarkHeader header;
+	bool ok = fread(&header, sizeof(header), 1, fp) == 1 && memcmp(header.magic, LANDMARK_MAGIC, 4) == 0
+		&& header.version == LANDMARK_VERSION && header.rows == map->rows && header.cols == map->cols
+		&& header.numLandmarks == numLandmarks && header.checksum == mapChecksum(map);
+	if (ok) {
+		size_t values = (size_t)map->rows*map->cols*numLandmarks;
+		lm->numLandmarks = numLandmarks;
+		lm->maxDistance = header.maxDistance;
+		lm->scale = landmarkScale(lm->maxDistance);
+		lm->landmarkPos = (int32_t *)malloc(numLandmarks*sizeof(int32_t));
+		lm->distance = (float *)malloc(values*sizeof(float));
+		ok = lm->landmarkPos != NULL && lm->distance != NULL
+			&& fread(lm->landmarkPos, sizeof(int32_t), numLandmarks, fp) == (size_t)numLandmarks
+			&& fread(lm->distance, sizeof(float), values, fp) == values && fgetc(fp) == EOF;
+		if (!ok)
+			landmarksFree(lm);
+	}
+	fclose(fp);
+	return ok;
+}
+
+/* Obtain "numLandmarks" landmarks of the map read from the file "mapName": their distance tables are read from
+"<mapName>.alt" if this file belongs to the map, otherwise they are computed and saved there. In case of an error an error
+message is shown and it is returned false. */
+static bool landmarksPrepare(Landmarks *lm, const Map *map, int numLandmarks, const char *mapName){
+	char fname[FILENAME_MAX];
+	snprintf(fname, sizeof(fname), "%s.alt", mapName);
+
+	printf("Reading the landmarks of the map... ");
+	if (landmarksLoad(lm, map, numLandmarks, fname)) {
+		printf("%d landmarks read from %s (%.1f MB).\n", lm->numLandmarks, fname, landmarkTableSize(lm, map) / 1048576.0);
+		return true;
+	}
+	printf("Not present or not up to date.\nComputing the distances from %d landmarks... ", numLandmarks);
+	struct timespec begin, end;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+	if (!landmarksBuild(lm, map, numLandmarks)) {
+		printf("\nFailed allocation or map without free cells.\n");
+		return false;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+	printf("Distances computed in %f s (%.1f MB).\n", seconds, landmarkTableSize(lm, map) / 1048576.0);
+	if (landmarksSave(lm, map, fname))
+		printf("Landmarks saved in %s.\n", fname);
+	else
+		printf("Warning: the landmarks could not be saved in %s.\n", fname);
+	return true;
+}
+
+#endif
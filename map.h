@@ -0,0 +1,497 @@
+#ifndef MAP_H
+#define MAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* Map on which the search is performed. Its dimensions are not fixed at compile time: they are obtained from the map file
+itself, so that the same executable can be used with every map present in the "maps" folder.
+Cells are stored with one bit each (1 = free, 0 = occupied), and every row starts at a new 64-bit word. This is also the
+payload of the binary map format, so a binary map file is mapped in memory with mmap() and used as it is, without parsing.
+
+For the searches the map can also be kept as a walkability grid with one byte per cell (1 = free, 0 = occupied) and a border
+of occupied cells all around it (see mapBorderInit()): the eight neighbors of a cell are then always inside the grid, at fixed
+offsets from it, and no bounds check is needed while a cell is expanded.
+Instead of the grid, a table with the walkability mask of every cell can be built (see mapMaskInit()): bit i of the mask of a
+cell is set if its i-th neighbor is free, the neighbors being numbered row by row (see mapNeighborDelta). The expansion then
+reads one byte and visits the set bits, and a rule such as the one on corner cutting is a mask operation.
+
+Binary map format (little-endian):
+	MapHeader		"AMAP" magic, version, rows, cols, percentage of obstacles, seed, checksum of the payload
+	payload			rows * words 64-bit words, where words = (cols + 63) / 64 */
+
+#define MAP_MAGIC "AMAP"		// First 4 bytes of a binary map file
+#define MAP_VERSION 1			// Version of the binary map format
+#define MAP_UNKNOWN_OBST -1		// Percentage of obstacles not known (e.g. map converted from a text file with another name)
+#define MAP_UNKNOWN_SEED 0xFFFFFFFFu	// Seed not known (e.g. map converted from a text file)
+
+typedef struct {
+	char magic[4];				// MAP_MAGIC
+	uint32_t version;			// MAP_VERSION
+	uint32_t rows, cols;		// Dimensions of the map
+	int32_t obstacles;			// Percentage of obstacles used to create the map
+	uint32_t seed;				// Seed used to create the map
+	uint64_t checksum;			// Checksum of the payload (see mapChecksum())
+} MapHeader;
+
+typedef struct {
+	int rows, cols;				// Dimensions of the map
+	int words;					// Number of 64-bit words of each row
+	uint64_t *bits;				// Bit (c % 64) of bits[r*words + c/64] is 1 if the cell (r, c) is free, 0 if it is occupied
+	int obstacles;				// Percentage of obstacles (MAP_UNKNOWN_OBST if not known)
+	uint32_t seed;				// Seed used to create the map (MAP_UNKNOWN_SEED if not known)
+	void *mapping;				// Start of the memory-mapped file (NULL if "bits" has been allocated with malloc)
+	size_t mappingSize;			// Size of the memory-mapped file
+	unsigned char *walk;		// Walkability grid with the border: cell (r, c) in walk[(r+1)*(cols+2) + c+1] (NULL if not built)
+	unsigned char *mask;		// Walkability mask of the cell (r, c) in mask[r*cols + c] (NULL if not built)
+} Map;
+
+// Row and column offsets of the neighbor of a cell that corresponds to bit i of a walkability mask: the neighbors row by row,
+// NW N NE W E SW S SE. The neighbor of bit i sees the cell in bit 7 - i
+static const int mapNeighborDelta[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+// Cost of the move towards the neighbor of bit i: 1 (straight) or sqrt(2) (diagonal)
+static const double mapNeighborCost[8] = {1.4142135623730951, 1.0, 1.4142135623730951, 1.0, 1.0, 1.4142135623730951, 1.0, 1.4142135623730951};
+
+/* Check if the cell (r, c) of the map is free. If it is, it is returned true, otherwise false. */
+static inline bool mapIsFree(const Map *map, int r, int c){
+	return (map->bits[(size_t)r*map->words + (c >> 6)] >> (c & 63)) & 1;
+}
+
+/* Return the index of the cell (r, c) in the walkability grid (see mapBorderInit()). Rows and columns from -1 to rows and cols
+are the border. */
+static inline size_t mapWalkIndex(const Map *map, int r, int c){
+	return (size_t)(r + 1)*(map->cols + 2) + c + 1;
+}
+
+/* Return the walkability mask of the cell (r, c) (see mapNeighborDelta) obtained from the walkability grid, without branches. */
+static inline unsigned int mapWalkMask(const Map *map, int r, int c){
+	const unsigned char *w = map->walk + mapWalkIndex(map, r, c);
+	size_t stride = (size_t)map->cols + 2;
+	return w[-stride-1] | w[-stride] << 1 | w[-stride+1] << 2 | w[-1] << 3 | w[1] << 4 | w[stride-1] << 5 | w[stride] << 6
+		| w[stride+1] << 7;
+}
+
+/* Remove from a walkability mask the diagonal moves that cut a corner, i.e., the ones for which one of the two straight moves
+towards the same cell is blocked. */
+static inline unsigned int mapMaskNoCornerCutting(unsigned int mask){
+	unsigned int n = (mask >> 1) & 1, w = (mask >> 3) & 1, e = (mask >> 4) & 1, s = (mask >> 6) & 1;
+	return mask & (0x5A | (n & w) | (n & e) << 2 | (s & w) << 5 | (s & e) << 7);
+}
+
+/* Mark the cell (r, c) of the map as free (free = true) or occupied (free = false). */
+static inline void mapSetCell(Map *map, int r, int c, bool free){
+	if (map->walk != NULL)
+		map->walk[mapWalkIndex(map, r, c)] = free;
+	for (int i = 0; map->mask != NULL && i < 8; i++) {
+		int nr = r + mapNeighborDelta[i][0], nc = c + mapNeighborDelta[i][1];
+		if (nr < 0 || nr >= map->rows || nc < 0 || nc >= map->cols)
+			continue;
+		unsigned char *mask = &map->mask[(size_t)nr*map->cols + nc];
+		*mask = free ? (*mask | 1 << (7 - i)) : (*mask & ~(1 << (7 - i)));
+	}
+	uint64_t *word = &map->bits[(size_t)r*map->words + (c >> 6)];
+	uint64_t mask = (uint64_t)1 << (c & 63);
+	if (free)
+		*word |= mask;
+	else
+		*word &= ~mask;
+}
+
+/* Allocation of a map of rows x cols cells, all of them occupied. It is returned false in case of failed allocation. */
+static bool mapAlloc(Map *map, int rows, int cols){
+	map->rows = rows;
+	map->cols = cols;
+	map->words = (cols + 63) / 64;
+	map->obstacles = MAP_UNKNOWN_OBST;
+	map->seed = MAP_UNKNOWN_SEED;
+	map->mapping = NULL;
+	map->mappingSize = 0;
+	map->walk = NULL;
+	map->mask = NULL;
+	map->bits = (uint64_t *)calloc((size_t)rows*map->words, sizeof(uint64_t));
+	return map->bits != NULL;
+}
+
+/* Free the cells of the map, unmapping the file if the map has been loaded from a binary file. */
+static void freeMap(Map *map){
+	if (map->mapping != NULL)
+		munmap(map->mapping, map->mappingSize);
+	else
+		free(map->bits);
+	free(map->walk);
+	free(map->mask);
+	map->bits = NULL;
+	map->mapping = NULL;
+	map->walk = NULL;
+	map->mask = NULL;
+}
+
+/* Build the walkability grid of the map: (rows + 2) x (cols + 2) bytes, the cells of the map surrounded by a border of
+occupied cells. The cells changed later with mapSetCell() are kept up to date. It is returned false in case of failed
+allocation. */
+static inline bool mapBorderInit(Map *map){
+	size_t stride = (size_t)map->cols + 2;
+	map->walk = (unsigned char *)calloc((map->rows + 2)*stride, sizeof(unsigned char));
+	if (map->walk == NULL)
+		return false;
+#ifdef _OPENMP
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int r = 0; r < map->rows; r++) {
+		unsigned char *row = map->walk + mapWalkIndex(map, r, 0);
+		for (int c = 0; c < map->cols; c++)
+			row[c] = mapIsFree(map, r, c);
+	}
+	return true;
+}
+
+/* Transpose the walkability masks of 8 cells: byte d of "planes" holds bit d of the masks of the cells (bit j of the byte for
+the j-th cell), the 8 masks are returned one per byte. */
+static inline uint64_t mapTranspose8(uint64_t x){
+	uint64_t t;
+	t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+	x ^= t ^ (t << 7);
+	t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+	x ^= t ^ (t << 14);
+	t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+	x ^= t ^ (t << 28);
+	return x;
+}
+
+/* Build the walkability masks of the 64 cells of the word "w" of the row "r" (fewer in the last word of the row). The eight
+neighbors of all the cells of the word are obtained at once, as 64-bit words shifted by one column (the bit-planes of the
+masks); then every group of 8 cells has its masks transposed from the planes, with SSE2 two groups at a time. */
+static void mapMaskWord(Map *map, int r, int w){
+	uint64_t left[3], center[3], right[3];		// Rows r - 1, r, r + 1 shifted to the west neighbor, as they are, to the east one
+	for (int i = 0; i < 3; i++) {
+		int row = r - 1 + i;
+		if (row < 0 || row >= map->rows) {
+			left[i] = center[i] = right[i] = 0;
+			continue;
+		}
+		const uint64_t *bits = map->bits + (size_t)row*map->words;
+		uint64_t prev = (w > 0) ? bits[w-1] : 0, next = (w + 1 < map->words) ? bits[w+1] : 0;
+		center[i] = bits[w];
+		left[i] = (bits[w] << 1) | (prev >> 63);
+		right[i] = (bits[w] >> 1) | (next << 63);
+	}
+	uint64_t plane[8] = {left[0], center[0], right[0], left[1], right[1], left[2], center[2], right[2]};
+
+	int cells = (map->cols - 64*w < 64) ? map->cols - 64*w : 64;
+	unsigned char *out = map->mask + (size_t)r*map->cols + 64*w;
+	unsigned char group[64];		// Masks of the 64 cells
+	for (int g = 0; g < 8; g += 2) {
+		uint64_t x[2] = {0, 0};		// Byte g (and g + 1) of every plane
+		for (int d = 0; d < 8; d++) {
+			x[0] |= ((plane[d] >> (8*g)) & 0xFF) << (8*d);
+			x[1] |= ((plane[d] >> (8*g + 8)) & 0xFF) << (8*d);
+		}
+#ifdef __SSE2__
+		// The sign bits of the 16 bytes are bit j of the planes of the two groups: every movemask gives the masks of two cells
+		__m128i v = _mm_set_epi64x((long long)x[1], (long long)x[0]);
+		for (int j = 7; j >= 0; j--) {
+			unsigned int m = _mm_movemask_epi8(v);
+			group[8*g + j] = m & 0xFF;
+			group[8*g + 8 + j] = m >> 8;
+			v = _mm_slli_epi64(v, 1);
+		}
+#else
+		uint64_t t0 = mapTranspose8(x[0]), t1 = mapTranspose8(x[1]);
+		memcpy(group + 8*g, &t0, 8);
+		memcpy(group + 8*g + 8, &t1, 8);
+#endif
+	}
+	memcpy(out, group, cells);
+}
+
+/* Build the table of the walkability masks of the map (one byte per cell, see mapNeighborDelta), row by row in parallel. The
+cells changed later with mapSetCell() are kept up to date. It is returned false in case of failed allocation. */
+static inline bool mapMaskInit(Map *map){
+	map->mask = (unsigned char *)malloc((size_t)map->rows*map->cols);
+	if (map->mask == NULL)
+		return false;
+#ifdef _OPENMP
+	#pragma omp parallel for schedule(static)
+#endif
+	for (int r = 0; r < map->rows; r++) {
+		for (int w = 0; w < map->words; w++)
+			mapMaskWord(map, r, w);
+	}
+	return true;
+}
+
+/* Check if the positions of the cells of the map (row*cols + col), used by the searches in memory, fit in an int. If they do not, an
+error message is shown and it is returned false: such a map has to be converted into a tiled map and searched with a-star-tiled.c
+(see "tiled-map.h"). The differences of rows and columns are squared in double by the distances of the searches, so the shape of
+the map does not matter. */
+static inline bool mapFitsInt(const Map *map){
+	if ((int64_t)map->rows*map->cols <= INT32_MAX)
+		return true;
+	printf("Error: the map has too many cells for the searches in memory, use a tiled map (convert-map -t) and a-star-tiled.\n");
+	return false;
+}
+
+/* Return the number of free cells of the map. */
+static long long mapFreeCells(const Map *map){
+	long long count = 0;
+	for (size_t i = 0; i < (size_t)map->rows*map->words; i++)
+		count += __builtin_popcountll(map->bits[i]);
+	return count;
+}
+
+/* Return the checksum of the cells of the map (64-bit FNV-1a computed over the words of the payload). */
+static uint64_t mapChecksum(const Map *map){
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < (size_t)map->rows*map->words; i++) {
+		hash ^= map->bits[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+/* Decode 8 cells of a row of a text map, i.e., the 16 characters "c c c c c c c c " where every c is 0 or 1. The cells are
+returned in the lowest 8 bits of *cells (bit i = cell i). It is returned false if the characters do not follow this layout.
+With SSE2 the 16 characters are compared all together and the values of the cells are extracted from the byte mask. */
+static inline bool decodeTextCells(const char *text, uint64_t *cells){
+#ifdef __SSE2__
+	__m128i v = _mm_loadu_si128((const __m128i *)text);
+	unsigned int ones = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('1')));
+	unsigned int zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('0')));
+	unsigned int spaces = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+	if (((ones | zeros) & 0x5555) != 0x5555 || (spaces & 0xAAAA) != 0xAAAA)
+		return false;
+	unsigned int x = ones & 0x5555;		// Cell i is in bit 2*i: the even bits are packed into the lowest 8 bits
+	x = (x | (x >> 1)) & 0x3333;
+	x = (x | (x >> 2)) & 0x0F0F;
+	x = (x | (x >> 4)) & 0x00FF;
+	*cells = x;
+	return true;
+#else
+	uint64_t x = 0;
+	for (int i = 0; i < 8; i++) {
+		if ((text[2*i] != '0' && text[2*i] != '1') || text[2*i+1] != ' ')
+			return false;
+		x |= (uint64_t)(text[2*i] == '1') << i;
+	}
+	*cells = x;
+	return true;
+#endif
+}
+
+/* Decode a row of a text map ("len" characters, line terminator excluded) into the words "row" of the map. It is returned false
+if the row is malformed. */
+static bool decodeTextRow(const char *text, size_t len, int cols, uint64_t *row){
+	int c;
+	uint64_t cells;
+	for (c = 0; 2*(size_t)c + 16 <= len && c + 8 <= cols; c += 8) {
+		if (!decodeTextCells(text + 2*c, &cells))
+			return false;
+		row[c >> 6] |= cells << (c & 63);		// c is a multiple of 8, so the 8 cells never cross a word
+	}
+	for (; c < cols; c++) {
+		if ((text[2*c] != '0' && text[2*c] != '1') || (2*(size_t)c + 1 < len && text[2*c+1] != ' '))
+			return false;
+		if (text[2*c] == '1')
+			row[c >> 6] |= (uint64_t)1 << (c & 63);
+	}
+	return true;
+}
+
+/* Read a text map file, i.e., a file containing several 0s and 1s separated by spaces, where the value 0 indicates that the
+cell is occupied (i.e., there is an obstacle), while the value 1 indicates that the cell is free. Every line of the file is a
+row of the map and the number of columns is obtained from the first line.
+The file is mapped in memory and the beginning of every line is found first; then the rows are decoded in parallel (one
+block of rows per OpenMP thread), 8 cells at a time. Every row must have the same length as the first one and contain only
+0s and 1s followed by a space (the last space and a final '\r' may be missing): otherwise the first malformed line is reported
+and it is returned false. */
+static bool loadTextMap(Map *map, int fd, const char *fname){
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		printf("Error: %s is not a valid map file.\n", fname);
+		return false;
+	}
+
+	size_t size = st.st_size;
+	const char *data = (const char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		printf("Error while mapping the input file.\n");
+		return false;
+	}
+	madvise((void *)data, size, MADV_SEQUENTIAL);
+
+	// Beginning and length (without line terminator) of every line
+	int rows = 0, allocLines = 1024;
+	size_t *lineStart = (size_t *)malloc(allocLines*sizeof(size_t));
+	size_t *lineLen = (size_t *)malloc(allocLines*sizeof(size_t));
+	size_t pos = 0;
+	bool ok = (lineStart != NULL && lineLen != NULL);
+	while (ok && pos < size) {
+		const char *nl = (const char *)memchr(data + pos, '\n', size - pos);
+		size_t end = (nl != NULL) ? (size_t)(nl - data) : size;
+		size_t len = end - pos;
+		if (len > 0 && data[end-1] == '\r')
+			len--;
+		if (rows >= allocLines) {
+			allocLines *= 2;
+			size_t *s = (size_t *)realloc(lineStart, allocLines*sizeof(size_t));
+			size_t *l = (size_t *)realloc(lineLen, allocLines*sizeof(size_t));
+			if (s != NULL)
+				lineStart = s;
+			if (l != NULL)
+				lineLen = l;
+			ok = (s != NULL && l != NULL);
+			if (!ok)
+				break;
+		}
+		lineStart[rows] = pos;
+		lineLen[rows] = len;
+		rows++;
+		pos = end + 1;
+	}
+	while (ok && rows > 0 && lineLen[rows-1] == 0)	// Empty lines at the end of the file
+		rows--;
+
+	if (!ok) {
+		printf("\nFailed allocation.\n");
+	} else if (rows == 0 || lineLen[0] < 1 || rows > INT32_MAX) {
+		printf("Error: %s is not a valid map file.\n", fname);
+		ok = false;
+	}
+
+	int cols = ok ? (int)((lineLen[0] + 1) / 2) : 0;
+	if (ok && !mapAlloc(map, rows, cols)) {
+		printf("\nFailed allocation.\n");
+		ok = false;
+	}
+
+	if (ok) {
+		int badRow = rows;		// First malformed row
+#ifdef _OPENMP
+		#pragma omp parallel for schedule(static) reduction(min:badRow)
+#endif
+		for (int r = 0; r < rows; r++) {
+			if ((lineLen[r] != 2*(size_t)cols && lineLen[r] != 2*(size_t)cols - 1)
+					|| !decodeTextRow(data + lineStart[r], lineLen[r], cols, &map->bits[(size_t)r*map->words]))
+				badRow = (r < badRow) ? r : badRow;
+		}
+		if (badRow < rows) {
+			if (lineLen[badRow] != 2*(size_t)cols && lineLen[badRow] != 2*(size_t)cols - 1)
+				printf("Error: line %d of %s has %zu characters, while the first line has %d values.\n", badRow+1, fname, lineLen[badRow], cols);
+			else
+				printf("Error: line %d of %s contains values different from 0 and 1 or values not separated by a space.\n", badRow+1, fname);
+			freeMap(map);
+			ok = false;
+		}
+	}
+
+	free(lineStart);
+	free(lineLen);
+	munmap((void *)data, size);
+	return ok;
+}
+
+/* Map a binary map file in memory. The header is validated (magic, version, size of the file and checksum of the payload)
+and the payload is then used directly as the cells of the map. The mapping is private, so changing a cell (e.g. to make the
+starting point free) does not modify the file. In case of an error an error message is shown and it is returned false. */
+static bool loadBinaryMap(Map *map, int fd, const char *fname){
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MapHeader)) {
+		printf("Error: %s is not a valid binary map file.\n", fname);
+		return false;
+	}
+
+	void *mapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	if (mapping == MAP_FAILED) {
+		printf("Error while mapping the input file.\n");
+		return false;
+	}
+
+	// The dimensions are checked before anything is derived from them: the number of words of a row is computed in 64 bits, since
+	// "cols + 63" does not fit in an int when "cols" is close to INT32_MAX
+	const MapHeader *header = (const MapHeader *)mapping;
+	int64_t words = ((int64_t)header->cols + 63) / 64;
+	if (header->version != MAP_VERSION || header->rows == 0 || header->cols == 0 || header->rows > INT32_MAX || header->cols > INT32_MAX
+			|| (uint64_t)st.st_size != sizeof(MapHeader) + (uint64_t)header->rows*words*sizeof(uint64_t)) {
+		printf("Error: %s is not a valid binary map file.\n", fname);
+		munmap(mapping, st.st_size);
+		return false;
+	}
+
+	map->rows = (int)header->rows;
+	map->cols = (int)header->cols;
+	map->words = (int)words;
+	map->obstacles = header->obstacles;
+	map->seed = header->seed;
+	map->bits = (uint64_t *)((char *)mapping + sizeof(MapHeader));
+	map->mapping = mapping;
+	map->mappingSize = st.st_size;
+	map->walk = NULL;
+	map->mask = NULL;
+	if (mapChecksum(map) != header->checksum) {
+		printf("Error: checksum mismatch in %s, the file is corrupted.\n", fname);
+		freeMap(map);
+		return false;
+	}
+	return true;
+}
+
+/* This function has the purpose of building the map from the file "fname" (usually one of the "map-dim%d-obst%d" files
+present in the "maps" folder). The file can be either a text map or a binary map: the two are told apart by the first bytes
+of the file. In case of an error an error message is shown and it is returned false. */
+static inline bool fillMap(Map *map, const char *fname){
+	printf("Opening file %s...\n", fname);
+
+	FILE *fp;
+	bool ok;
+	char magic[4];
+
+	fp = fopen(fname,"rb");
+
+	if (fp == NULL){
+		printf("Error while opening the input file.\n");
+		return false;
+	}
+
+	printf("Filling map... ");
+	if (fread(magic, 1, 4, fp) == 4 && memcmp(magic, MAP_MAGIC, 4) == 0) {
+		ok = loadBinaryMap(map, fileno(fp), fname);
+	} else {
+		ok = loadTextMap(map, fileno(fp), fname);
+	}
+	fclose(fp);
+
+	if (ok)
+		printf("Map %dx%d filled with %lld free cells.\n", map->rows, map->cols, mapFreeCells(map));
+	return ok;
+}
+
+/* Write the map in the binary format in the file "fname". It is returned false in case of error. */
+static inline bool saveBinaryMap(const Map *map, const char *fname){
+	MapHeader header;
+	memcpy(header.magic, MAP_MAGIC, 4);
+	header.version = MAP_VERSION;
+	header.rows = map->rows;
+	header.cols = map->cols;
+	header.obstacles = map->obstacles;
+	header.seed = map->seed;
+	header.checksum = mapChecksum(map);
+
+	FILE *fp = fopen(fname, "wb");
+	if (fp == NULL)
+		return false;
+	size_t words = (size_t)map->rows*map->words;
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 && fwrite(map->bits, sizeof(uint64_t), words, fp) == words;
+	return (fclose(fp) == 0) && ok;
+}
+
+#endif
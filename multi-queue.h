@@ -0,0 +1,173 @@
+#ifndef MULTI_QUEUE_H
+#define MULTI_QUEUE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+#include <omp.h>
+
+/* Relaxed concurrent priority queue (MultiQueue): MULTI_QUEUE_FACTOR binary heaps per thread, each one protected by its own
+lock. A cell is pushed in a random heap; a pop looks at the best cells of two random heaps and removes the better one, so the
+cell extracted is not always the best of the whole queue but close to it, and the threads rarely wait for the same lock.
+The heaps have no handles: a cell can be in the queue several times, with the value of "g" it had when it was pushed, and the
+entries that have become out of date are skipped by the search. */
+
+#define MULTI_QUEUE_FACTOR 2		// Heaps per thread
+#define MULTI_QUEUE_ATTEMPTS 8		// Failed random pops after which all the heaps are scanned
+
+typedef struct {
+	double f;					// Total cost of the cell (priority)
+	double g;					// Value of "g" of the cell when it was pushed
+	int pos;					// Position of the cell
+} MultiQueueNode;
+
+typedef struct {
+	MultiQueueNode *heap;		// Binary heap - the cell having the lowest value of "f" is in the first position
+	int size;					// Number of cells in the heap
+	int alloc;					// Number of elements allocated for "heap"
+	double top;					// Value of "f" of the first cell (INFINITY if the heap is empty) - read without the lock
+	omp_lock_t lock;			// Lock of the heap
+	char padding[64];			// Keeps the heaps used by different threads on different cache lines
+} MultiQueueHeap;
+
+typedef struct {
+	MultiQueueHeap *heaps;		// Heaps of the queue
+	int numHeaps;				// Number of heaps
+} MultiQueue;
+
+/* Random number generator of a thread (xorshift). */
+static inline uint32_t multiQueueRandom(uint32_t *state){
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+/* Allocation of an empty queue for "numThreads" threads, each heap with room for "alloc" cells. It is returned false in case of
+failed allocation. */
+static bool multiQueueInit(MultiQueue *mq, int numThreads, int alloc){
+	mq->numHeaps = MULTI_QUEUE_FACTOR*numThreads;
+	mq->heaps = (MultiQueueHeap *)calloc(mq->numHeaps, sizeof(MultiQueueHeap));
+	if (mq->heaps == NULL)
+		return false;
+	for (int i = 0; i < mq->numHeaps; i++) {
+		MultiQueueHeap *h = &mq->heaps[i];
+		h->alloc = alloc;
+		h->top = INFINITY;
+		h->heap = (MultiQueueNode *)malloc(alloc*sizeof(MultiQueueNode));
+		omp_init_lock(&h->lock);
+		if (h->heap == NULL) {
+			for (int j = 0; j <= i; j++) {
+				free(mq->heaps[j].heap);
+				omp_destroy_lock(&mq->heaps[j].lock);
+			}
+			free(mq->heaps);
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Free the heaps of the queue. */
+static void multiQueueFree(MultiQueue *mq){
+	for (int i = 0; i < mq->numHeaps; i++) {
+		free(mq->heaps[i].heap);
+		omp_destroy_lock(&mq->heaps[i].lock);
+	}
+	free(mq->heaps);
+}
+
+/* Add a node to a heap whose lock is held + possible reallocation of the heap. It is returned false in case of failed
+allocation. */
+static bool multiQueueHeapPush(MultiQueueHeap *h, MultiQueueNode node){
+	if (h->size >= h->alloc) {
+		MultiQueueNode *heap = (MultiQueueNode *)realloc(h->heap, 2*h->alloc*sizeof(MultiQueueNode));
+		if (heap == NULL)
+			return false;
+		h->heap = heap;
+		h->alloc *= 2;
+	}
+	int i = h->size++;
+	while (i > 0 && node.f < h->heap[(i - 1) / 2].f) {
+		h->heap[i] = h->heap[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	h->heap[i] = node;
+	#pragma omp atomic write
+	h->top = h->heap[0].f;
+	return true;
+}
+
+/* Remove the first node of a non-empty heap whose lock is held. */
+static MultiQueueNode multiQueueHeapPop(MultiQueueHeap *h){
+	MultiQueueNode first = h->heap[0];
+	MultiQueueNode last = h->heap[--h->size];
+	int i = 0;
+	while (1) {
+		int child = 2*i + 1;
+		if (child >= h->size)
+			break;
+		if (child + 1 < h->size && h->heap[child+1].f < h->heap[child].f)
+			child++;
+		if (!(h->heap[child].f < last.f))
+			break;
+		h->heap[i] = h->heap[child];
+		i = child;
+	}
+	if (h->size > 0)
+		h->heap[i] = last;
+	#pragma omp atomic write
+	h->top = (h->size > 0) ? h->heap[0].f : INFINITY;
+	return first;
+}
+
+/* Add a cell to a random heap of the queue ("seed" is the state of the random number generator of the thread). It is returned
+false in case of failed allocation. */
+static bool multiQueuePush(MultiQueue *mq, uint32_t *seed, double f, double g, int pos){
+	MultiQueueNode node = {f, g, pos};
+	MultiQueueHeap *h;
+	do {
+		h = &mq->heaps[multiQueueRandom(seed) % mq->numHeaps];
+	} while (!omp_test_lock(&h->lock));
+	bool ok = multiQueueHeapPush(h, node);
+	omp_unset_lock(&h->lock);
+	return ok;
+}
+
+/* Remove a cell from the queue: the better of the first cells of two random heaps. After MULTI_QUEUE_ATTEMPTS attempts that
+find both heaps empty or locked, the heaps are scanned in order. It is returned false if all the heaps are empty. */
+static bool multiQueuePop(MultiQueue *mq, uint32_t *seed, MultiQueueNode *node){
+	for (int attempt = 0; attempt < MULTI_QUEUE_ATTEMPTS; attempt++) {
+		MultiQueueHeap *a = &mq->heaps[multiQueueRandom(seed) % mq->numHeaps];
+		MultiQueueHeap *b = &mq->heaps[multiQueueRandom(seed) % mq->numHeaps];
+		double topA, topB;
+		#pragma omp atomic read
+		topA = a->top;
+		#pragma omp atomic read
+		topB = b->top;
+		MultiQueueHeap *h = (topB < topA) ? b : a;
+		if ((topB < topA ? topB : topA) == INFINITY || !omp_test_lock(&h->lock))
+			continue;
+		bool found = h->size > 0;
+		if (found)
+			*node = multiQueueHeapPop(h);
+		omp_unset_lock(&h->lock);
+		if (found)
+			return true;
+	}
+	for (int i = 0; i < mq->numHeaps; i++) {
+		MultiQueueHeap *h = &mq->heaps[i];
+		omp_set_lock(&h->lock);
+		bool found = h->size > 0;
+		if (found)
+			*node = multiQueueHeapPop(h);
+		omp_unset_lock(&h->lock);
+		if (found)
+			return true;
+	}
+	return false;
+}
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef OPEN_SET_H
+#define OPEN_SET_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "arena.h"
+#include "search-stats.h"
+
+/* Open set of the A* search, implemented as an indexed binary min-heap. Every cell of the map has a handle, i.e., its
+position inside the heap (or -1 if the cell is not in the open set), so that membership is a single load and the value of
+"f" of a cell already in the open set can be decreased in O(log n).
+Cells having the same value of "f" are extracted starting from the one inserted last, i.e., in the same order in which the
+previous linear scan of the "openSet" vector selected them.
+The positions of the cells and the positions inside the heap are of type OPEN_SET_INDEX, the insertion numbers of type
+OPEN_SET_SEQ: a program can define them before including this file, e.g., as 64-bit integers for the maps of more than 2^31 cells
+(see a-star-tiled.c). */
+
+#ifndef OPEN_SET_INDEX
+#define OPEN_SET_INDEX int
+#endif
+#ifndef OPEN_SET_SEQ
+#define OPEN_SET_SEQ unsigned int
+#endif
+
+typedef struct {
+	double f;					// Total cost of the cell (priority)
+	OPEN_SET_SEQ seq;			// Insertion number of the cell - used to break ties between equal values of "f"
+	OPEN_SET_INDEX pos;					// Position of the cell in the vector "arrayCells[]"
+} OpenSetNode;
+
+typedef struct {
+	OpenSetNode *heap;			// Binary heap - the cell having the lowest value of "f" is in the first position
+	OPEN_SET_INDEX *handle;		// Position of every cell inside "heap" (-1 if the cell is not in the open set)
+	OPEN_SET_INDEX size;		// Number of cells in the open set
+	OPEN_SET_INDEX alloc;		// Number of elements allocated for "heap"
+	OPEN_SET_SEQ seq;			// Number of insertions performed so far
+#if SEARCH_STATS
+	long long pushes;			// Operations performed since the open set was last emptied (see "search-stats.h")
+	long long pops;
+	long long decreaseKeys;
+	OPEN_SET_INDEX peak;		// Highest number of cells in the open set
+	int reallocs;				// Reallocations of "heap"
+	double reallocTime;			// Time spent in them, in seconds
+#endif
+} OpenSet;
+
+/* Reset the statistics of the open set (nothing is done when they are not collected). */
+static inline void openSetResetStats(OpenSet *os){
+#if SEARCH_STATS
+	os->pushes = os->pops = os->decreaseKeys = 0;
+	os->peak = os->reallocs = 0;
+	os->reallocTime = 0.0;
+#else
+	(void)os;
+#endif
+}
+
+/* Return true if the node "a" has to be extracted before the node "b", false otherwise. */
+static inline bool openSetBefore(const OpenSetNode *a, const OpenSetNode *b){
+	if (a->f != b->f)
+		return a->f < b->f;
+	return a->seq > b->seq;
+}
+
+/* Place "node" at position "i" of the heap and update its handle. */
+static inline void openSetPlace(OpenSet *os, OPEN_SET_INDEX i, OpenSetNode node){
+	os->heap[i] = node;
+	os->handle[node.pos] = i;
+}
+
+/* Move the node in position "i" towards the root until the heap property is restored. */
+static void openSetSiftUp(OpenSet *os, OPEN_SET_INDEX i){
+	OpenSetNode node = os->heap[i];
+	while (i > 0) {
+		OPEN_SET_INDEX parent = (i - 1) / 2;
+		if (!openSetBefore(&node, &os->heap[parent]))
+			break;
+		openSetPlace(os, i, os->heap[parent]);
+		i = parent;
+	}
+	openSetPlace(os, i, node);
+}
+
+/* Move the node in position "i" towards the leaves until the heap property is restored. */
+static void openSetSiftDown(OpenSet *os, OPEN_SET_INDEX i){
+	OpenSetNode node = os->heap[i];
+	while (1) {
+		OPEN_SET_INDEX child = 2*i + 1;
+		if (child >= os->size)
+			break;
+		if (child + 1 < os->size && openSetBefore(&os->heap[child+1], &os->heap[child]))
+			child++;
+		if (!openSetBefore(&os->heap[child], &node))
+			break;
+		openSetPlace(os, i, os->heap[child]);
+		i = child;
+	}
+	openSetPlace(os, i, node);
+}
+
+/* Allocation of an empty open set for a map of "numCells" cells. It is returned false in case of failed allocation. */
+static bool openSetInit(OpenSet *os, OPEN_SET_INDEX numCells, OPEN_SET_INDEX alloc){
+	os->size = 0;
+	os->seq = 0;
+	openSetResetStats(os);
+	os->alloc = alloc;
+	os->heap = (OpenSetNode *)malloc((size_t)alloc*sizeof(OpenSetNode));
+	os->handle = (OPEN_SET_INDEX *)malloc((size_t)numCells*sizeof(OPEN_SET_INDEX));
+	if (os->heap == NULL || os->handle == NULL) {
+		free(os->heap);
+		free(os->handle);
+		return false;
+	}
+	for (OPEN_SET_INDEX i = 0; i < numCells; i++)
+		os->handle[i] = -1;
+	return true;
+}
+
+/* Allocation of an empty open set for "numCells" cells, whose vectors are taken from the arena "arena" (see "arena.h"). The
+heap has room for all the cells, so it is never reallocated; the open set is released with the arena, not with openSetFree().
+It is returned false if the arena does not have room for it. */
+static inline bool openSetInitArena(OpenSet *os, OPEN_SET_INDEX numCells, Arena *arena){
+	os->size = 0;
+	os->seq = 0;
+	openSetResetStats(os);
+	os->alloc = numCells;
+	os->heap = (OpenSetNode *)arenaAlloc(arena, (size_t)numCells*sizeof(OpenSetNode));
+	os->handle = (OPEN_SET_INDEX *)arenaAlloc(arena, (size_t)numCells*sizeof(OPEN_SET_INDEX));
+	if (os->heap == NULL || os->handle == NULL)
+		return false;
+	for (OPEN_SET_INDEX i = 0; i < numCells; i++)
+		os->handle[i] = -1;
+	return true;
+}
+
+/* Return the number of bytes taken from an arena by an open set for "numCells" cells (see openSetInitArena()). */
+static inline size_t openSetArenaBytes(OPEN_SET_INDEX numCells){
+	return arenaBytes((size_t)numCells*sizeof(OpenSetNode)) + arenaBytes((size_t)numCells*sizeof(OPEN_SET_INDEX));
+}
+
+/* Make room for the handles of "numCells" cells, of which the first "oldCells" already have one, when the cells are not known
+in advance (see a-star-tiled.c): the new cells are not in the open set. It is returned false in case of failed allocation. */
+static inline bool openSetGrowCells(OpenSet *os, OPEN_SET_INDEX oldCells, OPEN_SET_INDEX numCells){
+	OPEN_SET_INDEX *handle = (OPEN_SET_INDEX *)realloc(os->handle, (size_t)numCells*sizeof(OPEN_SET_INDEX));
+	if (handle == NULL)
+		return false;
+	os->handle = handle;
+	for (OPEN_SET_INDEX i = oldCells; i < numCells; i++)
+		os->handle[i] = -1;
+	return true;
+}
+
+/* Empty the open set, so that it can be used for a new search. Only the handles of the cells still in the heap are reset. */
+static inline void openSetClear(OpenSet *os){
+	for (OPEN_SET_INDEX i = 0; i < os->size; i++)
+		os->handle[os->heap[i].pos] = -1;
+	os->size = 0;
+	os->seq = 0;
+	openSetResetStats(os);
+}
+
+/* Free the vectors of the open set. */
+static void openSetFree(OpenSet *os){
+	free(os->heap);
+	free(os->handle);
+}
+
+/* Check if a cell is in the open set. If it is, it is returned true, otherwise false. */
+static inline bool openSetContains(const OpenSet *os, OPEN_SET_INDEX pos){
+	return os->handle[pos] >= 0;
+}
+
+/* Return the position of the cell having the lowest value of "f" (the open set must not be empty). */
+static inline OPEN_SET_INDEX openSetTop(const OpenSet *os){
+	return os->heap[0].pos;
+}
+
+/* Return the lowest value of "f" in the open set (the open set must not be empty). */
+static inline double openSetTopF(const OpenSet *os){
+	return os->heap[0].f;
+}
+
+/* Add a cell that is not in the open set + possible reallocation of the heap. It is returned false in case of failed
+allocation. */
+static bool openSetPush(OpenSet *os, OPEN_SET_INDEX pos, double f){
+	if (os->size >= os->alloc) {
+#if SEARCH_STATS
+		double begin = statsClock();
+#endif
+		OpenSetNode *heap = (OpenSetNode *)realloc(os->heap, 2*(size_t)os->alloc*sizeof(OpenSetNode));
+		if (heap == NULL)
+			return false;
+		os->heap = heap;
+		os->alloc *= 2;
+		STATS(os->reallocs++; os->reallocTime += statsClock() - begin);
+	}
+	OpenSetNode node = {f, os->seq++, pos};
+	os->heap[os->size] = node;
+	os->handle[pos] = os->size;
+	os->size++;
+	STATS(os->pushes++; if (os->size > os->peak) os->peak = os->size);
+	openSetSiftUp(os, os->size - 1);
+	return true;
+}
+
+/* Remove the cell having the lowest value of "f" from the open set and return its position. */
+static OPEN_SET_INDEX openSetPop(OpenSet *os){
+	OPEN_SET_INDEX pos = os->heap[0].pos;
+	os->handle[pos] = -1;
+	os->size--;
+	STATS(os->pops++);
+	if (os->size > 0) {
+		openSetPlace(os, 0, os->heap[os->size]);
+		openSetSiftDown(os, 0);
+	}
+	return pos;
+}
+
+/* Restore the order of the heap after the values of "f" of its cells have been changed in place, e.g., recomputed with another
+weight of the heuristic. */
+static inline void openSetHeapify(OpenSet *os){
+	for (OPEN_SET_INDEX i = os->size/2 - 1; i >= 0; i--)
+		openSetSiftDown(os, i);
+}
+
+/* Lower the value of "f" of a cell that is already in the open set. */
+static void openSetDecreaseKey(OpenSet *os, OPEN_SET_INDEX pos, double f){
+	OPEN_SET_INDEX i = os->handle[pos];
+	if (f < os->heap[i].f) {
+		os->heap[i].f = f;
+		STATS(os->decreaseKeys++);
+		openSetSiftUp(os, i);
+	}
+}
+
+#endif
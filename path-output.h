@@ -0,0 +1,210 @@
+#ifndef PATH_OUTPUT_H
+#define PATH_OUTPUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "map.h"
+
+/* Writers of the path found by the search. The path is given as the vector of the positions (row*cols + col) of its cells,
+from the goal point (first element) to the starting point (last element), as it is built by the search. The output format is
+chosen at runtime:
+	grid		the whole map, one character per cell: 'X' obstacle, '.' free, 'O' path, 'S' start, 'G' goal
+	coords		one line "row col" per cell of the path, from the starting point to the goal point
+	runs		the starting point "row col" on the first line, then the moves as runs of the same direction, e.g. "SW12 S3 W1"
+	pgm			binary PGM (P5) image of the map: obstacles black, free cells white, path grey, start and goal dark grey
+PBM is not offered because a 1-bit image can not tell the path apart from the obstacles.
+The positions of the path are of type PATH_POSITION, which a program can define before including this file, e.g., as a 64-bit
+integer for the tiled maps (see a-star-tiled.c). The coords and runs writers only need the number of columns of the map, so they
+can be used also without a map in memory. */
+
+#ifndef PATH_POSITION
+#define PATH_POSITION int
+#endif
+
+#define OUT_BUFFER (8 << 20)	// Maximum dimension of the buffer used to print the map with the path (bytes)
+
+typedef enum {
+	OUTPUT_GRID,
+	OUTPUT_COORDS,
+	OUTPUT_RUNS,
+	OUTPUT_PGM
+} OutputFormat;
+
+typedef struct {
+	OutputFormat format;		// Format of the output file
+	char fname[FILENAME_MAX];	// Name of the output file
+} PathOutput;
+
+static const char *outputFormatNames[] = {"grid", "coords", "runs", "pgm"};
+static const char *outputExtensions[] = {"", ".coords", ".runs", ".pgm"};
+
+/* Obtain the output format from its name. It is returned false if the name is not valid. */
+static bool parseOutputFormat(const char *name, OutputFormat *format){
+	for (int i = 0; i < (int)(sizeof(outputFormatNames) / sizeof(outputFormatNames[0])); i++) {
+		if (strcmp(name, outputFormatNames[i]) == 0) {
+			*format = (OutputFormat)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Build the name of an output file for the map "mapName": a map called "map-dim%d-obst%d" (or "map-dim%d-obst%d.bin", ".tiles") gives
+the file "./paths/<prefix>dim%d-obst%d<extension>", any other map called "name" gives "./paths/<prefix>name<extension>". */
+static void outputFileName(const char *mapName, const char *prefix, const char *extension, char fname[], size_t size){
+	const char *base = strrchr(mapName, '/');
+	base = (base == NULL) ? mapName : base + 1;
+	if (strncmp(base, "map-", 4) == 0)
+		base += 4;
+	size_t len = strlen(base);
+	if (len > 4 && strcmp(base + len - 4, ".bin") == 0)
+		len -= 4;
+	else if (len > 6 && strcmp(base + len - 6, ".tiles") == 0)
+		len -= 6;
+	snprintf(fname, size, "./paths/%s%.*s%s", prefix, (int)len, base, extension);
+}
+
+/* Build the name of the file in which the path found on the map "mapName" is printed, e.g. "./paths/path-dim%d-obst%d" for
+the map "map-dim%d-obst%d", with the extension of the output format (none for the grid). */
+static void pathFileName(const char *mapName, OutputFormat format, char fname[], size_t size){
+	outputFileName(mapName, "path-", outputExtensions[format], fname, size);
+}
+
+/* Build the name of the file in which the results of the batch mode on the map "mapName" are written, e.g.
+"./paths/batch-dim%d-obst%d" for the map "map-dim%d-obst%d". */
+static inline void batchFileName(const char *mapName, char fname[], size_t size){
+	outputFileName(mapName, "batch-", "", fname, size);
+}
+
+/* Mark the cells of the path in an overlay with one byte per cell: 'O' for the cells of the path, 'S' for the starting point
+and 'G' for the goal point. The overlay is returned (NULL in case of failed allocation). */
+static char *pathOverlay(const Map *map, const PATH_POSITION path[], int pathSize){
+	char *overlay = (char *)calloc((size_t)map->rows*map->cols, sizeof(char));
+	if (overlay == NULL)
+		return NULL;
+	for (int b = 0; b < pathSize; b++)
+		overlay[path[b]] = 'O';					// Point of the path
+	overlay[path[pathSize-1]] = 'S';			// Starting point
+	overlay[path[0]] = 'G';						// Goal point
+	return overlay;
+}
+
+/* Print the map with the path. Every cell of the map is visited only once: the rows are formatted (in parallel when OpenMP
+is enabled) in a buffer of at most OUT_BUFFER bytes, which is written with a single call every time it is full. */
+static bool writeGrid(FILE *fp, const Map *map, const PATH_POSITION path[], int pathSize){
+	int r,c,first,last;
+	size_t rowLen = 2*(size_t)map->cols + 1;		// A character and a space for each cell + '\n'
+	int blockRows = (OUT_BUFFER / rowLen > 0) ? OUT_BUFFER / rowLen : 1;
+	if (blockRows > map->rows)
+		blockRows = map->rows;
+
+	char *overlay = pathOverlay(map, path, pathSize);
+	char *buffer = (char *)malloc(blockRows*rowLen);
+	bool ok = (overlay != NULL && buffer != NULL);
+
+	for (first=0; ok && first<map->rows; first+=blockRows){
+		last = (first + blockRows < map->rows) ? first + blockRows : map->rows;
+#ifdef _OPENMP
+		#pragma omp parallel for private(c)
+#endif
+		for (r=first; r<last; r++){
+			char *row = buffer + (size_t)(r-first)*rowLen;
+			const char *mark = overlay + (size_t)r*map->cols;
+			for (c=0; c<map->cols; c++){
+				if (mark[c])
+					row[2*c] = mark[c];
+				else if (!mapIsFree(map, r, c))
+					row[2*c] = 'X';
+				else
+					row[2*c] = '.';				// Free
+				row[2*c+1] = ' ';
+			}
+			row[rowLen-1] = '\n';
+		}
+		ok = (fwrite(buffer, rowLen, last-first, fp) == (size_t)(last-first));
+	}
+	free(overlay);
+	free(buffer);
+	return ok;
+}
+
+/* Print the coordinates of the cells of the path, from the starting point to the goal point. */
+static bool writeCoords(FILE *fp, int64_t cols, const PATH_POSITION path[], int64_t pathSize){
+	for (int64_t b = pathSize-1; b >= 0; b--) {
+		if (fprintf(fp, "%lld %lld\n", (long long)(path[b] / cols), (long long)(path[b] % cols)) < 0)
+			return false;
+	}
+	return true;
+}
+
+/* Print the path as runs of moves in the same direction, separated by spaces. Every direction is one of the 8 compass points
+(N is towards row 0, E towards the last column) followed by the number of consecutive moves, e.g. "SW12". */
+static bool writeMoves(FILE *fp, int64_t cols, const PATH_POSITION path[], int64_t pathSize){
+	static const char *names[3][3] = {{"NW", "N", "NE"}, {"W", "", "E"}, {"SW", "S", "SE"}};
+	int64_t run = 0;
+	int runRow = 0, runCol = 0;
+	bool ok = true;
+	for (int64_t b = pathSize-1; ok && b > 0; b--) {
+		int deltaRow = (int)(path[b-1] / cols - path[b] / cols);
+		int deltaCol = (int)(path[b-1] % cols - path[b] % cols);
+		if (run > 0 && (deltaRow != runRow || deltaCol != runCol)) {
+			ok = fprintf(fp, "%s%lld ", names[runRow+1][runCol+1], (long long)run) >= 0;
+			run = 0;
+		}
+		runRow = deltaRow;
+		runCol = deltaCol;
+		run++;
+	}
+	if (ok && run > 0)
+		ok = fprintf(fp, "%s%lld", names[runRow+1][runCol+1], (long long)run) >= 0;
+	return ok;
+}
+
+/* Print the starting point and then the path as runs of moves (see writeMoves()). */
+static bool writeRuns(FILE *fp, int64_t cols, const PATH_POSITION path[], int64_t pathSize){
+	return fprintf(fp, "%lld %lld\n", (long long)(path[pathSize-1] / cols), (long long)(path[pathSize-1] % cols)) >= 0
+		&& writeMoves(fp, cols, path, pathSize) && fprintf(fp, "\n") >= 0;
+}
+
+/* Print the map with the path as a binary PGM image, one pixel per cell. */
+static bool writePgm(FILE *fp, const Map *map, const PATH_POSITION path[], int pathSize){
+	char *overlay = pathOverlay(map, path, pathSize);
+	unsigned char *row = (unsigned char *)malloc(map->cols);
+	bool ok = (overlay != NULL && row != NULL) && fprintf(fp, "P5\n%d %d\n255\n", map->cols, map->rows) >= 0;
+	for (int r = 0; ok && r < map->rows; r++) {
+		const char *mark = overlay + (size_t)r*map->cols;
+		for (int c = 0; c < map->cols; c++) {
+			if (mark[c] == 'O')
+				row[c] = 128;		// Point of the path
+			else if (mark[c])
+				row[c] = 64;		// Starting or goal point
+			else
+				row[c] = mapIsFree(map, r, c) ? 255 : 0;
+		}
+		ok = (fwrite(row, 1, map->cols, fp) == (size_t)map->cols);
+	}
+	free(overlay);
+	free(row);
+	return ok;
+}
+
+/* Print the path in the file and in the format given by "output". It is returned false in case of error. */
+static inline bool writePath(const PathOutput *output, const Map *map, const PATH_POSITION path[], int pathSize){
+	FILE *fp = fopen(output->fname, (output->format == OUTPUT_PGM) ? "wb" : "w");
+	if (fp == NULL)
+		return false;
+	bool ok;
+	switch (output->format) {
+		case OUTPUT_COORDS:	ok = writeCoords(fp, map->cols, path, pathSize); break;
+		case OUTPUT_RUNS:	ok = writeRuns(fp, map->cols, path, pathSize); break;
+		case OUTPUT_PGM:	ok = writePgm(fp, map, path, pathSize); break;
+		default:			ok = writeGrid(fp, map, path, pathSize); break;
+	}
+	return (fclose(fp) == 0) && ok;
+}
+
+#endif
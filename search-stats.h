@@ -0,0 +1,84 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <stdio.h>
+#include <time.h>
+
+/* Statistics of a search, to see inside it: the cells expanded, the operations on the open set (insertions, extractions and
+decreases of "f"), the cells inserted again in the open set after they had been expanded, the highest sizes of the open set
+and of the closed set, the reallocations of the heap of the open set and of the other vectors of the search (path, best path
+and cells to be opened again), all the allocations of memory made by the search with the time spent in them, and the times of the
+phases (loading of the map, initialization of the cells, main loop of the search, reconstruction of the path and printing of
+the path). After every query they are printed as one JSON line, e.g.
+	{"engine": "astar", "query": [0, 999, 999, 0], "found": 1, "length": 1483.679508, "expanded": 195498, ...}
+The statistics are collected only when the programs are compiled with -DSEARCH_STATS=1. Otherwise the counters are not part
+of the data structures and every STATS() statement compiles to nothing, so that the searches are the same as without them.
+The closed set is a bitmap allocated once for the whole map (see "closed-set.h"), so it is never reallocated. */
+
+#ifndef SEARCH_STATS
+#define SEARCH_STATS 0
+#endif
+
+#if SEARCH_STATS
+#define STATS(statement) do { statement; } while (0)
+#else
+#define STATS(statement) do { } while (0)
+#endif
+
+typedef struct {
+	long long expanded;			// Cells expanded
+	long long pushes;			// Insertions in the open set
+	long long pops;				// Extractions from the open set
+	long long decreaseKeys;		// Values of "f" lowered in the open set
+	long long reopened;			// Cells inserted again in the open set after they had been expanded
+	int peakOpen;				// Highest number of cells in the open set
+	int peakClosed;				// Highest number of cells in the closed set
+	int openReallocs;			// Reallocations of the heap of the open set
+	int vectorReallocs;			// Reallocations of the other vectors of the search
+	int allocations;			// Allocations and reallocations of memory made by the search
+	double allocTime;			// Time spent in them, in seconds
+	double fillMap;				// Times of the phases, in seconds: loading of the map (only for a single search),
+	double initCells;			// initialization of the cells (and the rest of the preparation of the search),
+	double search;				// main loop of the search, without the reconstruction of the path,
+	double reconstruction;		// reconstruction of the path from the parents of the cells
+	double printPath;			// and printing of the path in the output file (only for a single search)
+} SearchStats;
+
+#if SEARCH_STATS
+/* Return the time of the monotonic clock, in seconds. */
+static inline double statsClock(){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/* Add the statistics "from" of a search to "to", e.g., of the two searches of the bidirectional search. */
+static void searchStatsAdd(SearchStats *to, const SearchStats *from){
+	to->expanded += from->expanded;
+	to->pushes += from->pushes;
+	to->pops += from->pops;
+	to->decreaseKeys += from->decreaseKeys;
+	to->reopened += from->reopened;
+	to->peakOpen += from->peakOpen;
+	to->peakClosed += from->peakClosed;
+	to->openReallocs += from->openReallocs;
+	to->vectorReallocs += from->vectorReallocs;
+	to->allocations += from->allocations;
+	to->allocTime += from->allocTime;
+	to->reconstruction += from->reconstruction;
+}
+
+/* Print the statistics of the query from "query[0]", "query[1]" to "query[2]", "query[3]" answered with the engine "engine" as
+one JSON line ("found" and "length" are the result of the search). The line is written with a single call, so that the lines of
+queries answered by different threads are not mixed. */
+static void searchStatsPrint(const SearchStats *s, const char *engine, const int query[4], int found, double length){
+	printf("{\"engine\": \"%s\", \"query\": [%d, %d, %d, %d], \"found\": %d, \"length\": %f, \"expanded\": %lld, \"pushes\": %lld, "
+		"\"pops\": %lld, \"decrease_keys\": %lld, \"reopened\": %lld, \"peak_open\": %d, \"peak_closed\": %d, \"open_reallocs\": %d, "
+		"\"vector_reallocs\": %d, \"allocations\": %d, \"alloc_time\": %f, \"fill_map\": %f, \"init_cells\": %f, \"search\": %f, "
+		"\"reconstruction\": %f, \"print_path\": %f}\n", engine, query[0], query[1], query[2], query[3], found, (found == 1) ? length : 0.0,
+		s->expanded, s->pushes, s->pops, s->decreaseKeys, s->reopened, s->peakOpen, s->peakClosed, s->openReallocs, s->vectorReallocs,
+		s->allocations, s->allocTime, s->fillMap, s->initCells, s->search, s->reconstruction, s->printPath);
+}
+#endif
+
+#endif
@@ -0,0 +1,262 @@
+#ifndef TILED_MAP_H
+#define TILED_MAP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "map.h"
+
+/* Tiled map, for the maps that do not fit in memory (or whose cells do not fit in an int, about 46000 x 46000 cells). The cells
+are stored in a file as square tiles of TILE_SIDE x TILE_SIDE cells, one bit each as in "map.h", and only the tiles that are
+needed are read, on demand, in a cache of a fixed number of tiles; when the cache is full the least recently used tile is
+evicted. A search touches the tiles around its frontier only, so the memory taken by the map does not depend on its size.
+Positions and dimensions are 64-bit.
+
+Tiled map format (little-endian):
+	TiledMapHeader	"ATIL" magic, version, rows, cols, side of the tiles, percentage of obstacles, seed
+	tiles			from the offset TILED_DATA_OFFSET, the tiles row by row of tiles, TILE_WORDS 64-bit words each: bit (c % 64) of
+					word r*(TILE_SIDE/64) + c/64 of a tile is 1 if its cell (r, c) is free, 0 if it is occupied or outside the map
+The file has no checksum, since checking it would mean reading the whole map. */
+
+#define TILED_MAGIC "ATIL"			// First 4 bytes of a tiled map file
+#define TILED_VERSION 1				// Version of the tiled map format
+#define TILE_SHIFT 8				// Side of the tiles as a power of 2
+#define TILE_SIDE (1 << TILE_SHIFT)	// Rows and columns of cells of a tile
+#define TILE_ROW_WORDS (TILE_SIDE / 64)			// 64-bit words of a row of a tile
+#define TILE_WORDS (TILE_SIDE * TILE_ROW_WORDS)	// 64-bit words of a tile (8 KB)
+#define TILED_DATA_OFFSET 4096		// Offset of the first tile in the file, so that every tile is aligned to a page
+#define TILED_MAX_SIDE ((uint64_t)1 << 40)	// Highest number of rows or columns of a tiled map
+
+typedef struct {
+	char magic[4];				// TILED_MAGIC
+	uint32_t version;			// TILED_VERSION
+	uint64_t rows, cols;		// Dimensions of the map
+	uint32_t tileSide;			// TILE_SIDE
+	int32_t obstacles;			// Percentage of obstacles used to create the map (MAP_UNKNOWN_OBST if not known)
+	uint32_t seed;				// Seed used to create the map (MAP_UNKNOWN_SEED if not known)
+	uint32_t reserved;			// Zero
+} TiledMapHeader;
+
+typedef struct {
+	long long lookups;			// Cells read
+	long long misses;			// Tiles read from the file, i.e., cells whose tile was not in the cache
+	long long evictions;		// Tiles removed from the cache to make room for other ones
+	double readTime;			// Time spent reading the tiles, in seconds
+} TiledMapStats;
+
+typedef struct {
+	int fd;						// Tiled map file
+	int64_t rows, cols;			// Dimensions of the map
+	int64_t tileRows, tileCols;	// Number of rows and columns of tiles
+	int obstacles;				// Percentage of obstacles (MAP_UNKNOWN_OBST if not known)
+	uint32_t seed;				// Seed used to create the map (MAP_UNKNOWN_SEED if not known)
+	int slots;					// Number of tiles the cache can hold
+	int used;					// Number of slots holding a tile
+	uint64_t *data;				// Cells of the tiles in the cache, TILE_WORDS words per slot
+	int64_t *slotTile;			// Tile held by every slot
+	int *prev, *next;			// List of the slots from the most recently used ("head") to the least recently used ("tail")
+	int head, tail;
+	int *tileSlot;				// Slot of every tile of the map (-1 if the tile is not in the cache)
+	int64_t lastTile;			// Tile of the last cell read (the head of the list, -1 if none) and its cells, so that reading
+	const uint64_t *lastData;	// cells of the same tile does not touch the list
+	bool error;					// A tile could not be read: its cells have been treated as occupied
+	TiledMapStats stats;
+} TiledMap;
+
+/* Fill the header of a tiled map of rows x cols cells. */
+static void tiledMapHeaderInit(TiledMapHeader *header, int64_t rows, int64_t cols, int obstacles, uint32_t seed){
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, TILED_MAGIC, 4);
+	header->version = TILED_VERSION;
+	header->rows = rows;
+	header->cols = cols;
+	header->tileSide = TILE_SIDE;
+	header->obstacles = obstacles;
+	header->seed = seed;
+}
+
+/* Rearrange "numRows" (at most TILE_SIDE) consecutive rows of a map, in the layout of "map.h" with "rowWords" words per row,
+into the "tileCols" tiles of the row of tiles that contains them, in "tiles" (tileCols*TILE_WORDS words). The rows of the
+tiles after the last row of the map and the columns after the last column are occupied. Since a row of a tile is made of whole
+words of the row of the map, the words are copied as they are. */
+static void tiledMapPackRows(const uint64_t rowBits[], int rowWords, int numRows, int64_t tileCols, uint64_t tiles[]){
+	memset(tiles, 0, (size_t)tileCols*TILE_WORDS*sizeof(uint64_t));
+	for (int r = 0; r < numRows; r++) {
+		const uint64_t *row = rowBits + (size_t)r*rowWords;
+		for (int w = 0; w < rowWords; w++)
+			tiles[(size_t)(w / TILE_ROW_WORDS)*TILE_WORDS + r*TILE_ROW_WORDS + w % TILE_ROW_WORDS] = row[w];
+	}
+}
+
+/* Write the map in the tiled format in the file "fname". It is returned false in case of error. */
+static inline bool saveTiledMap(const Map *map, const char *fname){
+	TiledMapHeader header;
+	tiledMapHeaderInit(&header, map->rows, map->cols, map->obstacles, map->seed);
+	int64_t tileCols = (map->cols + TILE_SIDE - 1) / TILE_SIDE;
+	uint64_t *tiles = (uint64_t *)malloc((size_t)tileCols*TILE_WORDS*sizeof(uint64_t));
+	FILE *fp = fopen(fname, "wb");
+	if (tiles == NULL || fp == NULL) {
+		free(tiles);
+		if (fp != NULL)
+			fclose(fp);
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 && fseek(fp, TILED_DATA_OFFSET, SEEK_SET) == 0;
+	for (int first = 0; ok && first < map->rows; first += TILE_SIDE) {
+		int numRows = (map->rows - first < TILE_SIDE) ? map->rows - first : TILE_SIDE;
+		tiledMapPackRows(map->bits + (size_t)first*map->words, map->words, numRows, tileCols, tiles);
+		ok = fwrite(tiles, sizeof(uint64_t), (size_t)tileCols*TILE_WORDS, fp) == (size_t)tileCols*TILE_WORDS;
+	}
+	free(tiles);
+	return (fclose(fp) == 0) && ok;
+}
+
+/* Free the cache and close the file of the tiled map. */
+static void tiledMapClose(TiledMap *tm){
+	if (tm->fd >= 0)
+		close(tm->fd);
+	free(tm->data);
+	free(tm->slotTile);
+	free(tm->prev);
+	free(tm->next);
+	free(tm->tileSlot);
+	tm->fd = -1;
+	tm->data = NULL;
+	tm->slotTile = NULL;
+	tm->prev = tm->next = tm->tileSlot = NULL;
+}
+
+/* Open the tiled map file "fname" with a cache of "cacheBytes" bytes (at least one tile). Only the header is read: the tiles are
+read when their cells are needed. In case of an error an error message is shown and it is returned false. */
+static inline bool tiledMapOpen(TiledMap *tm, const char *fname, size_t cacheBytes){
+	memset(tm, 0, sizeof(*tm));
+	tm->lastTile = -1;
+	tm->head = tm->tail = -1;
+	tm->fd = open(fname, O_RDONLY);
+	if (tm->fd < 0) {
+		printf("Error while opening the input file.\n");
+		return false;
+	}
+
+	TiledMapHeader header;
+	struct stat st;
+	if (pread(tm->fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || memcmp(header.magic, TILED_MAGIC, 4) != 0
+			|| header.version != TILED_VERSION || header.tileSide != TILE_SIDE || header.rows == 0 || header.cols == 0
+			|| header.rows > TILED_MAX_SIDE || header.cols > TILED_MAX_SIDE || fstat(tm->fd, &st) != 0) {
+		printf("Error: %s is not a valid tiled map file.\n", fname);
+		tiledMapClose(tm);
+		return false;
+	}
+	tm->rows = header.rows;
+	tm->cols = header.cols;
+	tm->tileRows = (tm->rows + TILE_SIDE - 1) / TILE_SIDE;
+	tm->tileCols = (tm->cols + TILE_SIDE - 1) / TILE_SIDE;
+	tm->obstacles = header.obstacles;
+	tm->seed = header.seed;
+	int64_t numTiles = tm->tileRows*tm->tileCols;
+	if (numTiles > INT32_MAX || (uint64_t)st.st_size != TILED_DATA_OFFSET + (uint64_t)numTiles*TILE_WORDS*sizeof(uint64_t)) {
+		printf("Error: %s is not a valid tiled map file.\n", fname);
+		tiledMapClose(tm);
+		return false;
+	}
+
+	size_t slots = cacheBytes / (TILE_WORDS*sizeof(uint64_t));
+	if (slots < 1)
+		slots = 1;
+	if (slots > (size_t)numTiles)
+		slots = numTiles;
+	tm->slots = (int)slots;
+	tm->data = (uint64_t *)malloc(slots*TILE_WORDS*sizeof(uint64_t));
+	tm->slotTile = (int64_t *)malloc(slots*sizeof(int64_t));
+	tm->prev = (int *)malloc(slots*sizeof(int));
+	tm->next = (int *)malloc(slots*sizeof(int));
+	tm->tileSlot = (int *)malloc((size_t)numTiles*sizeof(int));
+	if (tm->data == NULL || tm->slotTile == NULL || tm->prev == NULL || tm->next == NULL || tm->tileSlot == NULL) {
+		printf("Failed allocation of the tile cache.\n");
+		tiledMapClose(tm);
+		return false;
+	}
+	for (int64_t t = 0; t < numTiles; t++)
+		tm->tileSlot[t] = -1;
+	return true;
+}
+
+/* Move the slot "s" to the head of the list of the slots (the most recently used one). */
+static inline void tiledMapTouch(TiledMap *tm, int s){
+	if (tm->head == s)
+		return;
+	if (tm->prev[s] >= 0)
+		tm->next[tm->prev[s]] = tm->next[s];
+	if (tm->next[s] >= 0)
+		tm->prev[tm->next[s]] = tm->prev[s];
+	if (tm->tail == s)
+		tm->tail = tm->prev[s];
+	tm->prev[s] = -1;
+	tm->next[s] = tm->head;
+	if (tm->head >= 0)
+		tm->prev[tm->head] = s;
+	tm->head = s;
+	if (tm->tail < 0)
+		tm->tail = s;
+}
+
+/* Return the cells of the tile "tile", reading it from the file if it is not in the cache: it takes a free slot or, if the
+cache is full, the slot of the least recently used tile. It is returned NULL if the tile can not be read. */
+static const uint64_t *tiledMapLoad(TiledMap *tm, int64_t tile){
+	int s = tm->tileSlot[tile];
+	if (s < 0) {
+		bool fresh = tm->used < tm->slots;		// A slot never used is taken, otherwise the least recently used one
+		if (fresh) {
+			s = tm->used++;
+			tm->prev[s] = tm->next[s] = -1;
+		} else {
+			s = tm->tail;
+			if (tm->slotTile[s] >= 0) {		// Empty if a read failed in it
+				tm->tileSlot[tm->slotTile[s]] = -1;
+				tm->stats.evictions++;
+			}
+		}
+		struct timespec begin, end;
+		clock_gettime(CLOCK_MONOTONIC, &begin);
+		size_t bytes = TILE_WORDS*sizeof(uint64_t);
+		if (pread(tm->fd, tm->data + (size_t)s*TILE_WORDS, bytes, TILED_DATA_OFFSET + (off_t)tile*bytes) != (ssize_t)bytes) {
+			if (fresh)
+				tm->used--;				// The slot is not in the list yet, so it is given back
+			tm->slotTile[s] = -1;
+			tm->lastTile = -1;
+			return NULL;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		tm->stats.readTime += (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
+		tm->stats.misses++;
+		tm->slotTile[s] = tile;
+		tm->tileSlot[tile] = s;
+	}
+	tiledMapTouch(tm, s);
+	tm->lastTile = tile;
+	tm->lastData = tm->data + (size_t)s*TILE_WORDS;
+	return tm->lastData;
+}
+
+/* Check if the cell (r, c) of the map, which must be inside the map, is free. If it is, it is returned true, otherwise false. If
+its tile can not be read the cell is treated as occupied and the error is recorded in "tm->error". */
+static inline bool tiledMapIsFree(TiledMap *tm, int64_t r, int64_t c){
+	int64_t tile = (r >> TILE_SHIFT)*tm->tileCols + (c >> TILE_SHIFT);
+	const uint64_t *data = (tile == tm->lastTile) ? tm->lastData : tiledMapLoad(tm, tile);
+	tm->stats.lookups++;
+	if (data == NULL) {
+		tm->error = true;
+		return false;
+	}
+	int tr = r & (TILE_SIDE - 1), tc = c & (TILE_SIDE - 1);
+	return (data[tr*TILE_ROW_WORDS + (tc >> 6)] >> (tc & 63)) & 1;
+}
+
+#endif